@@ -0,0 +1,134 @@
+#pragma once
+
+#include "Common.hpp"
+
+class AhoCorasick
+{
+public:
+	struct Match
+	{
+		std::size_t pos;
+		std::size_t size;
+		int pattern;
+	};
+
+	void Build(const std::vector<std::string_view>& patterns)
+	{
+		states.clear();
+		states.emplace_back();
+		pattern_sizes.clear();
+		pattern_sizes.reserve(patterns.size());
+
+		for (int ip = 0; ip < (int)patterns.size(); ip++) {
+			auto& p = patterns[ip];
+			pattern_sizes.push_back(p.size());
+			if (p.empty()) {
+				continue;
+			}
+
+			int s = 0;
+			for (auto c : p) {
+				auto& edges = states[s].next;
+				auto it = std::find_if(edges.begin(), edges.end(), [c](const auto& e) { return e.first == (uint8_t)c; });
+				auto next = it == edges.end() ? -1 : it->second;
+				if (next < 0) {
+					next = (int)states.size();
+					states[s].next.emplace_back((uint8_t)c, next);
+					states.emplace_back();
+				}
+				s = next;
+			}
+			if (states[s].out < 0) {
+				states[s].out = ip;
+			}
+		}
+
+		for (auto& st : states) {
+			std::sort(st.next.begin(), st.next.end());
+		}
+
+		// bfs for failure and dictionary links, root transitions are kept dense.
+		root_next.fill(0);
+		std::vector<int> queue;
+		queue.reserve(states.size());
+		for (auto& e : states[0].next) {
+			root_next[e.first] = e.second;
+			states[e.second].fail = 0;
+			queue.push_back(e.second);
+		}
+		for (std::size_t iq = 0; iq < queue.size(); iq++) {
+			auto s = queue[iq];
+			for (auto& e : states[s].next) {
+				auto f = states[s].fail;
+				while (f != 0 && Goto(f, e.first) < 0) {
+					f = states[f].fail;
+				}
+				states[e.second].fail = f == 0 ? root_next[e.first] : Goto(f, e.first);
+
+				auto fs = states[e.second].fail;
+				states[e.second].dict = states[fs].out >= 0 ? fs : states[fs].dict;
+				queue.push_back(e.second);
+			}
+		}
+	}
+
+	std::size_t PatternCount() const { return pattern_sizes.size(); }
+
+	// non-overlapping matches from left to right, the longest pattern wins at each position.
+	std::vector<Match> FindAll(std::span<const char> text) const
+	{
+		std::vector<Match> candidates;
+		int s = 0;
+		auto size = text.size();
+		for (std::size_t i = 0; i < size; i++) {
+			auto c = (uint8_t)text[i];
+			int next = -1;
+			while (s != 0 && (next = Goto(s, c)) < 0) {
+				s = states[s].fail;
+			}
+			s = (s == 0) ? root_next[c] : next;
+
+			for (auto o = states[s].out >= 0 ? s : states[s].dict; o > 0; o = states[o].dict) {
+				auto ip = states[o].out;
+				candidates.push_back({ i + 1 - pattern_sizes[ip], pattern_sizes[ip], ip });
+			}
+		}
+
+		std::sort(candidates.begin(), candidates.end(), [](const Match& a, const Match& b) {
+			return a.pos != b.pos ? a.pos < b.pos : a.size > b.size;
+		});
+
+		std::vector<Match> matches;
+		std::size_t next_free = 0;
+		for (auto& m : candidates) {
+			if (m.pos >= next_free) {
+				matches.push_back(m);
+				next_free = m.pos + m.size;
+			}
+		}
+		return matches;
+	}
+
+private:
+	struct State
+	{
+		std::vector<std::pair<uint8_t, int>> next;
+		int fail = 0;
+		int out = -1;
+		int dict = 0;
+	};
+
+	int Goto(int s, uint8_t c) const
+	{
+		auto& next = states[s].next;
+		auto it = std::lower_bound(next.begin(), next.end(), c, [](const auto& e, uint8_t v) { return e.first < v; });
+		if (it == next.end() || it->first != c) {
+			return -1;
+		}
+		return it->second;
+	}
+
+	std::vector<State> states;
+	std::vector<std::size_t> pattern_sizes;
+	std::array<int, 256> root_next{};
+};
@@ -51,11 +51,41 @@ struct BMFont
 		std::size_t chnl;
 	};
 
+	static constexpr uint32_t NoChar = 0xFFFFFFFF;
+
 	Info info;
 	Common common;
 	std::vector<Page> pages;
 	std::vector<Char> chars;
 	bool force_offsets_to_zero;
+	std::vector<uint32_t> char_index; // id -> position in chars for the BMP, NoChar when missing
+
+	// called once chars is complete. the first char of an id wins, like a search from the front.
+	void BuildCharIndex()
+	{
+		char_index.assign(0x10000, NoChar);
+		for (std::size_t i = 0; i < chars.size(); i++) {
+			auto id = chars[i].id;
+			if (id < char_index.size() && char_index[id] == NoChar) {
+				char_index[id] = (uint32_t)i;
+			}
+		}
+	}
+
+	const Char* FindChar(std::size_t id) const
+	{
+		if (id < char_index.size()) {
+			auto idx = char_index[id];
+			return idx != NoChar ? &chars[idx] : nullptr;
+		}
+		return stdext::FindPtr<const Char>(chars, [id](const auto& elm) { return elm.id == id; });
+	}
+
+	// force_offsets_to_zero is kept only while every char passes this.
+	bool IsOffsetFree(const Char& ch) const
+	{
+		return ch.xoffset + info.padding[0] == 0 && ch.yoffset + info.padding[3] == 0;
+	}
 
 	int GetCharMinYoffset() const
 	{
@@ -85,57 +115,63 @@ class BMFontXmlReader {
 public:
 	static bool ReadInfo(rapidxml::xml_node<char>* node_info, BMFont& fnt)
 	{
+		static constexpr XmlNameTable info_attrs({ "face", "size", "bold", "italic", "charset", "unicode",
+			"stretchH", "smooth", "aa", "padding", "spacing", "outline" });
 		auto attr = node_info->first_attribute();
 		while (attr) {
-			if (false) {}
-			M_RAPID_XML_ATTR_IF_SET_STRING(attr, "face", fnt.info.face)
-				M_RAPID_XML_ATTR_IF_SET_INT(attr, "size", fnt.info.size)
-				M_RAPID_XML_ATTR_IF_SET_BOOL(attr, "bold", fnt.info.bold)
-				M_RAPID_XML_ATTR_IF_SET_BOOL(attr, "italic", fnt.info.italic)
-				M_RAPID_XML_ATTR_IF_SET_STRING(attr, "charset", fnt.info.charset)
-				M_RAPID_XML_ATTR_IF_SET_BOOL(attr, "unicode", fnt.info.unicode)
-				M_RAPID_XML_ATTR_IF_SET_INT(attr, "stretchH", fnt.info.stretchH)
-				M_RAPID_XML_ATTR_IF_SET_BOOL(attr, "smooth", fnt.info.smooth)
-				M_RAPID_XML_ATTR_IF_SET_BOOL(attr, "aa", fnt.info.aa)
-				M_RAPID_XML_ATTR_IF_SET_INT_ARRAY(attr, "padding", fnt.info.padding)
-				M_RAPID_XML_ATTR_IF_SET_INT_ARRAY(attr, "spacing", fnt.info.spacing)
-				M_RAPID_XML_ATTR_IF_SET_INT(attr, "outline", fnt.info.outline)
-
-				attr = attr->next_attribute();
+			switch (info_attrs.Find(XmlName(attr))) {
+			case info_attrs.Index("face"): fnt.info.face = attr->value(); break;
+			case info_attrs.Index("size"): SetInt(attr, fnt.info.size); break;
+			case info_attrs.Index("bold"): SetBool(attr, fnt.info.bold); break;
+			case info_attrs.Index("italic"): SetBool(attr, fnt.info.italic); break;
+			case info_attrs.Index("charset"): fnt.info.charset = attr->value(); break;
+			case info_attrs.Index("unicode"): SetBool(attr, fnt.info.unicode); break;
+			case info_attrs.Index("stretchH"): SetInt(attr, fnt.info.stretchH); break;
+			case info_attrs.Index("smooth"): SetBool(attr, fnt.info.smooth); break;
+			case info_attrs.Index("aa"): SetBool(attr, fnt.info.aa); break;
+			case info_attrs.Index("padding"): SetIntArray(attr, fnt.info.padding); break;
+			case info_attrs.Index("spacing"): SetIntArray(attr, fnt.info.spacing); break;
+			case info_attrs.Index("outline"): SetInt(attr, fnt.info.outline); break;
+			}
+			attr = attr->next_attribute();
 		}
 		return true;
 	}
 	static bool ReadCommon(rapidxml::xml_node<char>* node_common, BMFont& fnt)
 	{
+		static constexpr XmlNameTable common_attrs({ "lineHeight", "base", "scaleW", "scaleH", "pages", "packed",
+			"alphaChnl", "redChnl", "greenChnl", "blueChnl" });
 		auto attr = node_common->first_attribute();
 		while (attr) {
-			if (false) {}
-			M_RAPID_XML_ATTR_IF_SET_INT(attr, "lineHeight", fnt.common.lineHeight)
-				M_RAPID_XML_ATTR_IF_SET_INT(attr, "base", fnt.common.base)
-				M_RAPID_XML_ATTR_IF_SET_INT(attr, "scaleW", fnt.common.scaleW)
-				M_RAPID_XML_ATTR_IF_SET_INT(attr, "scaleH", fnt.common.scaleH)
-				M_RAPID_XML_ATTR_IF_SET_INT(attr, "pages", fnt.common.pages)
-				M_RAPID_XML_ATTR_IF_SET_BOOL(attr, "packed", fnt.common.packed)
-				M_RAPID_XML_ATTR_IF_SET_INT(attr, "alphaChnl", fnt.common.alphaChnl)
-				M_RAPID_XML_ATTR_IF_SET_INT(attr, "redChnl", fnt.common.redChnl)
-				M_RAPID_XML_ATTR_IF_SET_INT(attr, "greenChnl", fnt.common.greenChnl)
-				M_RAPID_XML_ATTR_IF_SET_INT(attr, "blueChnl", fnt.common.blueChnl)
-
-				attr = attr->next_attribute();
+			switch (common_attrs.Find(XmlName(attr))) {
+			case common_attrs.Index("lineHeight"): SetInt(attr, fnt.common.lineHeight); break;
+			case common_attrs.Index("base"): SetInt(attr, fnt.common.base); break;
+			case common_attrs.Index("scaleW"): SetInt(attr, fnt.common.scaleW); break;
+			case common_attrs.Index("scaleH"): SetInt(attr, fnt.common.scaleH); break;
+			case common_attrs.Index("pages"): SetInt(attr, fnt.common.pages); break;
+			case common_attrs.Index("packed"): SetBool(attr, fnt.common.packed); break;
+			case common_attrs.Index("alphaChnl"): SetInt(attr, fnt.common.alphaChnl); break;
+			case common_attrs.Index("redChnl"): SetInt(attr, fnt.common.redChnl); break;
+			case common_attrs.Index("greenChnl"): SetInt(attr, fnt.common.greenChnl); break;
+			case common_attrs.Index("blueChnl"): SetInt(attr, fnt.common.blueChnl); break;
+			}
+			attr = attr->next_attribute();
 		}
 		return true;
 	}
 	static bool ReadPages(rapidxml::xml_node<char>* node_pages, BMFont& fnt)
 	{
+		static constexpr XmlNameTable page_attrs({ "id", "file" });
 		auto node_page = node_pages->first_node();
 		while (node_page) {
 			BMFont::Page p{};
 			auto attr = node_page->first_attribute();
 			while (attr) {
-				if (false) {}
-				M_RAPID_XML_ATTR_IF_SET_INT(attr, "id", p.id)
-					M_RAPID_XML_ATTR_IF_SET_STRING(attr, "file", p.file)
-					attr = attr->next_attribute();
+				switch (page_attrs.Find(XmlName(attr))) {
+				case page_attrs.Index("id"): SetInt(attr, p.id); break;
+				case page_attrs.Index("file"): p.file = attr->value(); break;
+				}
+				attr = attr->next_attribute();
 			}
 			fnt.pages.push_back(p);
 			node_page = node_page->next_sibling();
@@ -145,26 +181,29 @@ public:
 	}
 	static bool ReadChars(rapidxml::xml_node<char>* node_chars, BMFont& fnt)
 	{
+		static constexpr XmlNameTable char_attrs({ "id", "x", "y", "width", "height", "xoffset", "yoffset",
+			"xadvance", "page", "chnl" });
 		fnt.force_offsets_to_zero = true;
 		auto node_char = node_chars->first_node();
 		while (node_char) {
 			BMFont::Char ch{};
 			auto attr = node_char->first_attribute();
 			while (attr) {
-				if (false) {}
-				M_RAPID_XML_ATTR_IF_SET_INT(attr, "id", ch.id)
-					M_RAPID_XML_ATTR_IF_SET_INT(attr, "x", ch.x)
-					M_RAPID_XML_ATTR_IF_SET_INT(attr, "y", ch.y)
-					M_RAPID_XML_ATTR_IF_SET_INT(attr, "width", ch.width)
-					M_RAPID_XML_ATTR_IF_SET_INT(attr, "height", ch.height)
-					M_RAPID_XML_ATTR_IF_SET_INT(attr, "xoffset", ch.xoffset)
-					M_RAPID_XML_ATTR_IF_SET_INT(attr, "yoffset", ch.yoffset)
-					M_RAPID_XML_ATTR_IF_SET_INT(attr, "xadvance", ch.xadvance)
-					M_RAPID_XML_ATTR_IF_SET_INT(attr, "page", ch.page)
-					M_RAPID_XML_ATTR_IF_SET_INT(attr, "chnl", ch.chnl)
-					attr = attr->next_attribute();
+				switch (char_attrs.Find(XmlName(attr))) {
+				case char_attrs.Index("id"): SetInt(attr, ch.id); break;
+				case char_attrs.Index("x"): SetInt(attr, ch.x); break;
+				case char_attrs.Index("y"): SetInt(attr, ch.y); break;
+				case char_attrs.Index("width"): SetInt(attr, ch.width); break;
+				case char_attrs.Index("height"): SetInt(attr, ch.height); break;
+				case char_attrs.Index("xoffset"): SetInt(attr, ch.xoffset); break;
+				case char_attrs.Index("yoffset"): SetInt(attr, ch.yoffset); break;
+				case char_attrs.Index("xadvance"): SetInt(attr, ch.xadvance); break;
+				case char_attrs.Index("page"): SetInt(attr, ch.page); break;
+				case char_attrs.Index("chnl"): SetInt(attr, ch.chnl); break;
+				}
+				attr = attr->next_attribute();
 			}
-			if (ch.xoffset + fnt.info.padding[0] != 0 || ch.yoffset + fnt.info.padding[3] != 0) {
+			if (!fnt.IsOffsetFree(ch)) {
 				fnt.force_offsets_to_zero = false;
 			}
 			fnt.chars.push_back(ch);
@@ -188,33 +227,219 @@ public:
 			return false;
 		}
 
+		static constexpr XmlNameTable font_nodes({ "info", "common", "pages", "chars" });
 		auto node = node_font->first_node();
 		while (node != nullptr) {
-			if (strcmp(node->name(), "info") == 0) {
-				if (!ReadInfo(node, fnt)) {
-					return false;
-				}
+			bool read = true;
+			switch (font_nodes.Find(XmlName(node))) {
+			case font_nodes.Index("info"): read = ReadInfo(node, fnt); break;
+			case font_nodes.Index("common"): read = ReadCommon(node, fnt); break;
+			case font_nodes.Index("pages"): read = ReadPages(node, fnt); break;
+			case font_nodes.Index("chars"): read = ReadChars(node, fnt); break;
 			}
-			else if (strcmp(node->name(), "common") == 0) {
-				if (!ReadCommon(node, fnt)) {
-					return false;
-				}
+			if (!read) {
+				return false;
 			}
-			else if (strcmp(node->name(), "pages") == 0) {
-				if (!ReadPages(node, fnt)) {
-					return false;
-				}
+			node = node->next_sibling();
+		}
+		fnt.BuildCharIndex();
+
+		return true;
+	}
+
+private:
+	template<typename T>
+	static void SetInt(rapidxml::xml_attribute<char>* attr, T& target)
+	{
+		target = (T)atoi(attr->value());
+	}
+	static void SetBool(rapidxml::xml_attribute<char>* attr, bool& target)
+	{
+		target = atoi(attr->value()) == 1;
+	}
+	// comma separated ints, a missing one reads as 0.
+	template<std::size_t N>
+	static void SetIntArray(rapidxml::xml_attribute<char>* attr, std::array<std::size_t, N>& target)
+	{
+		std::string_view value(attr->value(), attr->value_size());
+		for (std::size_t i = 0; i < N; i++) {
+			auto comma = value.find(',');
+			target[i] = atoi(std::string(value.substr(0, comma)).c_str());
+			value = comma == std::string_view::npos ? std::string_view() : value.substr(comma + 1);
+		}
+	}
+};
+
+// the binary descriptor (.fnt version 3), "BMF" + version then blocks of type (1 byte) + size (4 bytes) + data.
+class BMFontBinaryReader {
+public:
+	static bool IsBinary(std::span<const char> data)
+	{
+		return data.size() >= 4 && memcmp(data.data(), "BMF\3", 4) == 0;
+	}
+
+	static bool Read(std::span<const char> data, BMFont& fnt)
+	{
+		if (!IsBinary(data)) {
+			return false;
+		}
+
+		MemReader reader(data.data(), data.size());
+		reader.Forward(4);
+		while (!reader.IsEnd()) {
+			auto type = reader.Read<uint8_t>();
+			auto size = reader.Read<uint32_t>();
+			if (size == 0) {
+				continue;
 			}
-			else if (strcmp(node->name(), "chars") == 0) {
-				if (!ReadChars(node, fnt)) {
-					return false;
-				}
+			MemReader block(reader.Ptr(), size);
+			reader.Forward(size);
+			switch (type) {
+			case 1: ReadInfo(block, size, fnt); break;
+			case 2: ReadCommon(block, fnt); break;
+			case 3: ReadPages(block, size, fnt); break;
+			case 4: ReadChars(block, size, fnt); break;
 			}
-			node = node->next_sibling();
 		}
+		fnt.BuildCharIndex();
 
 		return true;
 	}
+
+private:
+#pragma pack(push, 1)
+	struct BinChar
+	{
+		uint32_t id;
+		uint16_t x;
+		uint16_t y;
+		uint16_t width;
+		uint16_t height;
+		int16_t xoffset;
+		int16_t yoffset;
+		int16_t xadvance;
+		uint8_t page;
+		uint8_t chnl;
+	};
+#pragma pack(pop)
+	static_assert(sizeof(BinChar) == 20);
+
+	static void ReadInfo(MemReader& block, std::size_t size, BMFont& fnt)
+	{
+		fnt.info.size = (std::size_t)block.Read<int16_t>();
+		auto bits = block.Read<uint8_t>();
+		fnt.info.smooth = (bits & 0x01) != 0;
+		fnt.info.unicode = (bits & 0x02) != 0;
+		fnt.info.italic = (bits & 0x04) != 0;
+		fnt.info.bold = (bits & 0x08) != 0;
+		auto charset = block.Read<uint8_t>();
+		fnt.info.charset = fnt.info.unicode ? "" : std::to_string(charset);
+		fnt.info.stretchH = block.Read<uint16_t>();
+		fnt.info.aa = block.Read<uint8_t>() == 1;
+		for (auto& p : fnt.info.padding) {
+			p = block.Read<uint8_t>();
+		}
+		for (auto& sp : fnt.info.spacing) {
+			sp = block.Read<uint8_t>();
+		}
+		fnt.info.outline = block.Read<uint8_t>();
+		fnt.info.face = ReadString(block, size);
+	}
+	static void ReadCommon(MemReader& block, BMFont& fnt)
+	{
+		fnt.common.lineHeight = block.Read<uint16_t>();
+		fnt.common.base = block.Read<uint16_t>();
+		fnt.common.scaleW = block.Read<uint16_t>();
+		fnt.common.scaleH = block.Read<uint16_t>();
+		fnt.common.pages = block.Read<uint16_t>();
+		fnt.common.packed = (block.Read<uint8_t>() & 0x80) != 0;
+		fnt.common.alphaChnl = block.Read<uint8_t>();
+		fnt.common.redChnl = block.Read<uint8_t>();
+		fnt.common.greenChnl = block.Read<uint8_t>();
+		fnt.common.blueChnl = block.Read<uint8_t>();
+	}
+	static void ReadPages(MemReader& block, std::size_t size, BMFont& fnt)
+	{
+		while ((std::size_t)block.CurrPos() < size) {
+			BMFont::Page p{};
+			p.id = fnt.pages.size();
+			p.file = ReadString(block, size);
+			fnt.pages.push_back(p);
+		}
+	}
+	static void ReadChars(MemReader& block, std::size_t size, BMFont& fnt)
+	{
+		fnt.force_offsets_to_zero = true;
+		auto count = size / sizeof(BinChar);
+		if (count == 0) {
+			return;
+		}
+		auto bin_chars = block.ReadVector<BinChar>(count);
+		fnt.chars.resize(bin_chars.size());
+		for (std::size_t i = 0; i < bin_chars.size(); i++) {
+			auto& bc = bin_chars[i];
+			auto& ch = fnt.chars[i];
+			ch.id = bc.id;
+			ch.x = bc.x;
+			ch.y = bc.y;
+			ch.width = bc.width;
+			ch.height = bc.height;
+			ch.xoffset = bc.xoffset;
+			ch.yoffset = bc.yoffset;
+			ch.xadvance = (std::size_t)bc.xadvance;
+			ch.page = bc.page;
+			ch.chnl = bc.chnl;
+			if (!fnt.IsOffsetFree(ch)) {
+				fnt.force_offsets_to_zero = false;
+			}
+		}
+	}
+	// null terminated, the block end stops an unterminated one.
+	static std::string ReadString(MemReader& block, std::size_t size)
+	{
+		auto begin = block.Ptr();
+		auto len = strnlen(begin, size - block.CurrPos());
+		block.Forward(std::min(len + 1, size - block.CurrPos()));
+		return std::string(begin, len);
+	}
+};
+
+// picks the reader from the file content, binary descriptors first and xml for the rest.
+class BMFontReader {
+public:
+	static bool Read(const fs::path& file_path, BMFont& fnt)
+	{
+		MappedFile file;
+		if (!file.Open(file_path)) {
+			return false;
+		}
+		std::span<const char> data(file.Data(), file.Size());
+		bool read = false;
+		if (BMFontBinaryReader::IsBinary(data)) {
+			// a block running past the end of the file throws from MemReader.
+			try {
+				read = BMFontBinaryReader::Read(data, fnt);
+			}
+			catch (const std::exception&) {
+				return false;
+			}
+		}
+		else {
+			file.Close();
+			read = BMFontXmlReader::Read(file_path, fnt);
+		}
+		if (!read) {
+			return false;
+		}
+
+		// the glyphs are cut from the pages by index.
+		for (auto& ch : fnt.chars) {
+			if (ch.page >= fnt.pages.size()) {
+				return false;
+			}
+		}
+		return true;
+	}
 };
 
 class BMFontOrderdPngExporter {
@@ -230,8 +455,9 @@ public:
 		src_height.resize(page_size);
 		for (std::size_t i = 0; i < page_size; i++) {
 			auto ppath = bmf_filepath.parent_path().append(bmf.pages[i].file);
-			src_data[i].resize(fs::file_size(ppath));
-			PngReader::Read(ppath, src_width[i], src_height[i], src_data[i]);
+			if (!PngReader::Read(ppath, src_width[i], src_height[i], src_data[i])) {
+				return false;
+			}
 		}
 
 		auto nsize = bmf.chars.size();
@@ -266,8 +492,10 @@ public:
 			png_rows[i] = &png_buffer[i * png_width];
 		}
 
-		FILE* fp;
-		fopen_s(&fp, (bmf_filepath.string() + ".png").c_str(), "wb");
+		auto fp = std::fopen((bmf_filepath.string() + ".png").c_str(), "wb");
+		if (fp == nullptr) {
+			return false;
+		}
 		auto png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
 		auto info_ptr = png_create_info_struct(png_ptr);
 		png_init_io(png_ptr, fp);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Common.hpp"
+#include "ThreadPool.hpp"
 
 
 uint32_t nonary_crypt(uint8_t* data, int size, uint32_t key, uint32_t relative_offset)
@@ -184,13 +185,6 @@ public:
 		Read(n->offset + header_offset4, buffer);
 		XOR(n->key, 0, buffer);
 	}
-	
-	static void ReadNodeMT(std::ifstream& ifs, const std::shared_ptr<Node>& n, std::vector<uint8_t>& buffer)
-	{
-		buffer.resize(n->size);
-		ifs.read((char*)buffer.data(), buffer.size());
-		XOR(n->key, 0, buffer);
-	}
 
 	uint64_t GetNextNodeOffset(uint64_t offset, uint64_t size) const
 	{
@@ -249,9 +243,31 @@ public:
 		auto pnode_offset = (uint32_t*)cur_pos; cur_pos += sizeof(uint32_t);
 		auto pnode_count = (uint32_t*)cur_pos; cur_pos += sizeof(uint32_t);
 
+		// the mod files are read and encrypted on the pool first, the nodes are then copied in file order.
+		std::vector<std::size_t> node_mods(*pnode_count, mod_file_paths.size());
+		std::vector<std::pair<std::size_t, uint32_t>> mod_reads; // node, key
+		for (std::size_t i = 0; i < *pnode_count; i++) {
+			Node node;
+			memcpy(&node, data_structure + *pnode_offset + i * sizeof(Node), sizeof(Node));
+			auto it = std::find(mod_file_ids.begin(), mod_file_ids.end(), node.id);
+			if (it != mod_file_ids.end()) {
+				node_mods[i] = std::distance(mod_file_ids.begin(), it);
+				mod_reads.emplace_back(i, node.key);
+			}
+		}
+		std::vector<std::vector<uint8_t>> mod_buffers(mod_reads.size());
+		ThreadPool::Shared().ParallelFor(mod_reads.size(), [&](std::size_t k) {
+			auto& [inode, key] = mod_reads[k];
+			auto& mod_path = mod_file_paths[node_mods[inode]];
+			mod_buffers[k].resize(fs::file_size(mod_path));
+			::ReadFile(mod_path, mod_buffers[k].data());
+			XOR(key, 0, mod_buffers[k]);
+		});
+
 		std::vector<uint8_t> node_buffer;
 		node_buffer.reserve(1024 * 1024 * 10);
 
+		std::size_t mod_read = 0;
 		uint64_t ndoe_offset_alloc = 0;
 		cur_pos = data_structure + *pnode_offset;
 		for (int i = 0; i < *pnode_count; i++) {
@@ -265,21 +281,19 @@ public:
 
 			auto pdata = buffer.data() + ndoe_offset_alloc + header_offset4;
 
-			auto it = std::find(mod_file_ids.begin(), mod_file_ids.end(), *pid);
-			if (it != mod_file_ids.end()) {
-				auto mod_offset = std::distance(mod_file_ids.begin(), it);
-				node_buffer.resize(fs::file_size(mod_file_paths[mod_offset]));
-				::ReadFile(mod_file_paths[mod_offset], node_buffer.data());
-				XOR(*pkey, 0, node_buffer);
+			std::span<const uint8_t> node_data;
+			if (node_mods[i] < mod_file_paths.size()) {
+				node_data = mod_buffers[mod_read++];
 				patched_count++;
 			}
 			else {
 				node_buffer.resize(*psize);
 				Read(*poffset + header_offset4, node_buffer);
+				node_data = node_buffer;
 			}
 
-			memcpy(pdata, node_buffer.data(), node_buffer.size());
-			*psize = node_buffer.size();
+			memcpy(pdata, node_data.data(), node_data.size());
+			*psize = node_data.size();
 			if (*poffset != ndoe_offset_alloc) {
 				printf("");
 			}
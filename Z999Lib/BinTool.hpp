@@ -17,7 +17,7 @@ public:
 
 		std::vector<fs::path> patch_files;
 		for (auto i : fs::recursive_directory_iterator{ patch_path }) {
-			if (i.is_regular_file()) {
+			if (i.is_regular_file() && i.path().extension() != ".manifest") {
 				patch_files.push_back(i);
 			}
 		}
@@ -60,63 +60,52 @@ public:
 			fs::create_directory(fs::path(dst_dir_path).append(ext));
 		}
 
-		const std::size_t THREAD_COUNT = std::thread::hardware_concurrency();
-
-		std::vector<std::shared_ptr<std::promise<int>>> ps(THREAD_COUNT);
-		std::vector<std::shared_future<int>> fs(THREAD_COUNT);
-		std::vector<std::shared_ptr<std::thread>> ts(THREAD_COUNT);
-		
-		for (int i = 0; i < THREAD_COUNT; i++) {
-			ps[i] = std::make_shared<std::promise<int>>();
-			fs[i] = ps[i]->get_future();
-			ts[i] = std::make_shared<std::thread>([&](int idx, std::shared_ptr<std::promise<int>> p) {
-				int count = 0;
-				auto size = bin.nodes.size();
-
-				std::vector<uint8_t> buffer;
-				buffer.reserve(1024 * 1024 * 10);
-
-				std::ifstream ifs;
-				ifs.open(bin.file_path, std::ifstream::binary);
-
-				for (std::size_t inode = idx; inode < size; inode += THREAD_COUNT) {
-					auto& n = bin.nodes[inode];
-
-					int ext_idx = 5;
-
-					ifs.seekg(n->offset + bin.header_offset4,ifs.beg);
-					if (n->size > 0) {
-						BinFile::ReadNodeMT(ifs, n, buffer);
-
-						for (int iext = 0; iext < 5; iext++) {
-							if (std::string_view((char*)buffer.data(), sigs[iext].size()) == sigs[iext]) {
-								ext_idx = iext;
-								break;
-							}
-						}
-					}
-					else {
-						buffer.clear();
+		// the bin is read in node order by one stream, decrypting and writing the nodes runs on the pool.
+		struct Item
+		{
+			std::size_t inode = 0;
+			std::vector<uint8_t> buffer;
+		};
+
+		std::ifstream ifs;
+		ifs.open(bin.file_path, std::ifstream::binary);
+
+		std::size_t next_node = 0;
+		auto& pool = ThreadPool::Shared();
+		pool.Pipeline<Item>(pool.Size() + 2, [&](Item& item) {
+			if (next_node >= bin.nodes.size()) {
+				return false;
+			}
+			item.inode = next_node++;
+			auto& n = bin.nodes[item.inode];
+			item.buffer.resize(n->size);
+			if (n->size > 0) {
+				ifs.seekg(n->offset + bin.header_offset4, ifs.beg);
+				ifs.read((char*)item.buffer.data(), item.buffer.size());
+			}
+			return true;
+		}, [&](Item& item) {
+			auto& n = bin.nodes[item.inode];
+			auto& buffer = item.buffer;
+
+			int ext_idx = 5;
+			if (n->size > 0) {
+				BinFile::XOR(n->key, 0, buffer);
+
+				for (int iext = 0; iext < 5; iext++) {
+					if (std::string_view((char*)buffer.data(), sigs[iext].size()) == sigs[iext]) {
+						ext_idx = iext;
+						break;
 					}
-
-					auto file_path = fs::path(dst_dir_path).append(exts[ext_idx]).append(ValueToHexString(n->id, false) + "." + exts[ext_idx]);
-					std::ofstream ofs(file_path, std::ios::binary);
-					ofs.write((char*)buffer.data(), buffer.size());
-
-					unpacked[ext_idx]++;
-					count++;
 				}
-				p->set_value(count);
-			}, i, ps[i]);
-		}
+			}
 
-		for (int i = 0; i < THREAD_COUNT; i++) {
-			fs[i].wait();
-		}
+			auto file_path = fs::path(dst_dir_path).append(exts[ext_idx]).append(ValueToHexString(n->id, false) + "." + exts[ext_idx]);
+			std::ofstream ofs(file_path, std::ios::binary);
+			ofs.write((char*)buffer.data(), buffer.size());
 
-		for (int i = 0; i < THREAD_COUNT; i++) {
-			ts[i]->join();
-		}
+			unpacked[ext_idx]++;
+		});
 
 		return true;
 	}
@@ -15,18 +15,28 @@
 #include <array>
 #include <vector>
 #include <list>
+#include <deque>
 #include <map>
 #include <set>
 #include <unordered_map>
 #include <unordered_set>
 #include <bitset>
+#include <bit>
 #include <span>
 #include <string>
+#include <optional>
 #include <algorithm>
 #include <memory>
 #include <clocale>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
 #include <future>
 #include <atomic>
+#include <thread>
+#include <mutex>
+#include <stdexcept>
+#include <charconv>
 #include <locale>
 #include <codecvt>
 
@@ -118,7 +128,7 @@ public:
 	void SetPos(std::span<char> _sp)
 	{
 		if (_sp.empty()) {
-			throw std::exception("!memory access");
+			throw std::runtime_error("!memory access");
 		}
 		sp = _sp;
 		pos = 0;
@@ -126,7 +136,7 @@ public:
 	void SetPos(std::span<uint8_t> _sp)
 	{
 		if (_sp.empty()) {
-			throw std::exception("!memory access");
+			throw std::runtime_error("!memory access");
 		}
 		sp = std::span<char>((char*)_sp.data(), _sp.size());
 		pos = 0;
@@ -135,7 +145,7 @@ public:
 	void Forward(std::size_t len)
 	{
 		if (pos + len > sp.size())
-			throw std::exception("!memory access");
+			throw std::runtime_error("!memory access");
 
 		pos += len;
 	}
@@ -143,7 +153,7 @@ public:
 	void Seek(std::size_t offset)
 	{
 		if (offset > sp.size())
-			throw std::exception("!memory access");
+			throw std::runtime_error("!memory access");
 
 		pos = (int)offset;
 	}
@@ -157,7 +167,7 @@ public:
 	T Read()
 	{
 		if (pos + sizeof(T) > sp.size())
-			throw std::exception("!memory access");
+			throw std::runtime_error("!memory access");
 
 		T out;
 		out = *((T*)Ptr());
@@ -169,7 +179,7 @@ public:
 	void Read(T& out)
 	{
 		if (pos + sizeof(T) > sp.size())
-			throw std::exception("!memory access");
+			throw std::runtime_error("!memory access");
 
 		out = *((T*)Ptr());
 		pos += sizeof(T);
@@ -179,17 +189,17 @@ public:
 	void ReadArray(std::size_t len, T* out)
 	{
 		if (pos + sizeof(T) * len > sp.size())
-			throw std::exception("!memory access");
+			throw std::runtime_error("!memory access");
 
 		memcpy(out, Ptr(), sizeof(T) * len);
 		pos += sizeof(T) * len;
 	}
-	template<typename T, int N>
+	template<typename T, std::size_t N>
 	void ReadArray(std::array<T, N>& out)
 	{
 		ReadArray(N, &out[0]);
 	}
-	template<typename T, int N>
+	template<typename T, std::size_t N>
 	std::array<T, N> ReadArray()
 	{
 		std::array<T, N> out;
@@ -240,7 +250,7 @@ public:
 		memcpy(pos, v, sizeof(T) * len);
 		pos += sizeof(T) * len;
 	}
-	template<typename T, int N>
+	template<typename T, std::size_t N>
 	void WriteArray(const std::array<T, N>& v)
 	{
 		WriteArray(&v[0], N);
@@ -257,6 +267,12 @@ inline void ReadFile(const fs::path& path, void* buffer)
 	std::ifstream ifs(path, std::ios::binary);
 	ifs.rdbuf()->sgetn((char*)buffer, fs::file_size(path));
 }
+inline bool WriteFile(const fs::path& path, const void* buffer, std::size_t size)
+{
+	std::ofstream ofs(path, std::ios::binary);
+	ofs.write((const char*)buffer, size);
+	return (bool)ofs;
+}
 inline std::string ReadText(const fs::path& path, std::size_t except_header_size = 0)
 {
 	std::ifstream ifs(path);
@@ -270,6 +286,130 @@ inline std::string ReadText(const fs::path& path, std::size_t except_header_size
 	return buffer.data();
 }
 
+inline uint64_t HashBytes(const void* data, std::size_t size, uint64_t seed = 0xCBF29CE484222325ULL)
+{
+	// FNV-1a
+	auto p = (const uint8_t*)data;
+	for (std::size_t i = 0; i < size; i++) {
+		seed ^= p[i];
+		seed *= 0x100000001B3ULL;
+	}
+	return seed;
+}
+inline uint64_t HashString(std::string_view s, uint64_t seed = 0xCBF29CE484222325ULL)
+{
+	return HashBytes(s.data(), s.size(), seed);
+}
+inline uint64_t HashFile(const fs::path& path, uint64_t seed = 0xCBF29CE484222325ULL)
+{
+	std::ifstream ifs(path, std::ios::binary);
+	if (!ifs) {
+		return seed;
+	}
+
+	std::vector<char> buffer;
+	buffer.resize(1024 * 1024);
+	while (ifs) {
+		ifs.read(buffer.data(), buffer.size());
+		seed = HashBytes(buffer.data(), (std::size_t)ifs.gcount(), seed);
+	}
+	return seed;
+}
+
+// the strings are spread over shards by hash, each with its own lock, so threads interning different strings rarely wait on each other.
+template<typename CharT>
+class StringPool
+{
+public:
+	using string_type = std::basic_string<CharT>;
+	using view_type = std::basic_string_view<CharT>;
+
+	StringPool()
+	{
+		empty = &Intern(view_type());
+	}
+
+	// the returned reference stays valid for the lifetime of the pool.
+	const string_type& Intern(view_type s)
+	{
+		// the high bits pick the shard, the maps bucket by the low ones.
+		auto& shard = shards[std::hash<view_type>()(s) >> (sizeof(std::size_t) * 8 - shard_bits)];
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		auto it = shard.index.find(s);
+		if (it != shard.index.end()) {
+			return *it->second;
+		}
+		auto& stored = shard.strings.emplace_back(s);
+		shard.index.emplace(view_type(stored), &stored);
+		return stored;
+	}
+
+	const string_type& Empty() const
+	{
+		return *empty;
+	}
+
+	std::size_t Size() const
+	{
+		std::size_t size = 0;
+		for (auto& shard : shards) {
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			size += shard.strings.size();
+		}
+		return size;
+	}
+
+private:
+	static constexpr int shard_bits = 4;
+
+	struct Shard
+	{
+		mutable std::mutex mutex;
+		std::deque<string_type> strings;
+		std::unordered_map<view_type, const string_type*> index;
+	};
+	std::array<Shard, 1 << shard_bits> shards;
+	const string_type* empty = nullptr;
+};
+
+// string stored once in a process-wide pool, equal strings share the same storage and compare by address.
+template<typename CharT>
+class InternedString
+{
+public:
+	using string_type = std::basic_string<CharT>;
+	using view_type = std::basic_string_view<CharT>;
+
+	static StringPool<CharT>& Pool()
+	{
+		static StringPool<CharT> pool;
+		return pool;
+	}
+
+	InternedString() : str(&Pool().Empty()) {}
+	InternedString(view_type s) : str(&Pool().Intern(s)) {}
+	InternedString(const CharT* s) : str(&Pool().Intern(s)) {}
+	InternedString(const string_type& s) : str(&Pool().Intern(s)) {}
+
+	operator const string_type& () const { return *str; }
+	operator view_type() const { return *str; }
+	const string_type& String() const { return *str; }
+	const CharT* c_str() const { return str->c_str(); }
+	const CharT* data() const { return str->data(); }
+	std::size_t length() const { return str->length(); }
+	std::size_t size() const { return str->size(); }
+	bool empty() const { return str->empty(); }
+	CharT operator[](std::size_t i) const { return (*str)[i]; }
+	auto begin() const { return str->begin(); }
+	auto end() const { return str->end(); }
+
+	bool operator==(const InternedString& other) const { return str == other.str; }
+	bool operator<(const InternedString& other) const { return *str < *other.str; }
+
+private:
+	const string_type* str;
+};
+
 class uintvar {
 public:
 	uintvar(uint64_t value) {
@@ -341,95 +481,88 @@ inline std::vector<uint8_t> HexStringToBytes(const std::string& hex) {
 }
 
 
+#include "Sjis.hpp"
+#include "Utf.hpp"
+
+inline void utf8_to_wcs(std::string_view src, std::wstring& dst)
+{
+	if (utf::to_wcs(src, dst) != utf::error::none) {
+		throw std::range_error("invalid utf-8");
+	}
+}
 inline std::wstring utf8_to_wcs(const std::string& src)
 {
-	std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-	return converter.from_bytes(src);
+	std::wstring dst;
+	utf8_to_wcs(src, dst);
+	return dst;
+}
+inline void wcs_to_utf8(std::wstring_view src, std::string& dst)
+{
+	if (utf::from_wcs(src, dst) != utf::error::none) {
+		throw std::range_error("invalid utf-16");
+	}
 }
 inline std::string wcs_to_utf8(const std::wstring& src)
 {
-	std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-	return converter.to_bytes(src);
+	std::string dst;
+	wcs_to_utf8(src, dst);
+	return dst;
 }
 
 inline std::wstring mbs_to_wcs(const std::string& src)
 {
-	if (src.empty()) {
-		return L"";
-	}
-
-	std::size_t converted{};
-	std::vector<wchar_t> dest(src.size() + 1, L'\0');
-	if (::mbstowcs_s(&converted, dest.data(), dest.size(), src.data(), _TRUNCATE) != 0) {
-		throw std::system_error{ errno, std::system_category() };
+	std::wstring dest;
+	if (sjis::to_wcs(src.c_str(), dest) != sjis::error::none) {
+		throw std::range_error("invalid shift-jis");
 	}
-	dest.resize(std::char_traits<wchar_t>::length(dest.data()));
-	dest.shrink_to_fit();
-	return std::wstring(dest.begin(), dest.end());
+	return dest;
 }
 inline std::wstring mbs_to_wcs(const std::string& src, const std::wstring& err_default)
 {
-	try {
-		return mbs_to_wcs(src);
-	}
-	catch (const std::exception& e) {
+	std::wstring dest;
+	if (sjis::to_wcs(src.c_str(), dest) != sjis::error::none) {
 		return err_default;
 	}
+	return dest;
 }
 
 inline std::string wcs_to_mbs(const std::wstring& src)
 {
-	if (src.empty()) {
-		return "";
-	}
-
-	std::size_t converted{};
-	std::vector<char> dest(src.size() * sizeof(wchar_t) + 1, '\0');
-	if (::wcstombs_s(&converted, dest.data(), dest.size(), src.data(), _TRUNCATE) != 0) {
-		throw std::system_error{ errno, std::system_category() };
+	std::string dest;
+	if (sjis::from_wcs(src.c_str(), dest) != sjis::error::none) {
+		throw std::range_error("unmappable to shift-jis");
 	}
-	dest.resize(std::char_traits<char>::length(dest.data()));
-	dest.shrink_to_fit();
-	return std::string(dest.begin(), dest.end());
+	return dest;
 }
 inline std::string wcs_to_mbs(const std::wstring& src, const std::string& err_default)
 {
-	try {
-		return wcs_to_mbs(src);
-	}
-	catch (const std::exception& e) {
+	std::string dest;
+	if (sjis::from_wcs(src.c_str(), dest) != sjis::error::none) {
 		return err_default;
 	}
+	return dest;
 }
 
 inline std::string mbs_to_utf8(const std::string& src) {
-	try {
-		return wcs_to_utf8(mbs_to_wcs(src));
-	}
-	catch (const std::exception& e) {
+	std::string dest;
+	if (sjis::to_utf8(src.c_str(), dest) != sjis::error::none) {
 		return src;
 	}
+	return dest;
 }
 
 inline std::string utf8_to_mbs(const std::string& src)
 {
-	try {
-		return wcs_to_mbs(utf8_to_wcs(src));
-	}
-	catch (const std::exception& e) {
+	std::string dest;
+	if (sjis::from_utf8(src.c_str(), dest) != sjis::error::none) {
 		return src;
 	}
+	return dest;
 }
 
 inline bool sjis_valid(const std::string& src)
 {
-	try {
-		mbs_to_wcs(src);
-		return true;
-	}
-	catch (const std::exception& e) {
-		return false;
-	}
+	return sjis::valid(src.c_str());
 }
 
 #include "../include/rapidxml/rapidxml.hpp"
@@ -452,30 +585,134 @@ inline const wchar_t* RapidXmlString(rapidxml::xml_document<wchar_t>& doc, const
 	return doc.allocate_string(v.c_str(), v.size() + 1);
 }
 
-#define M_RAPID_XML_ATTR_IF_SET_STRING(attr, attr_name, target)\
-else if (strcmp(attr->name(), attr_name) == 0) {\
-	target = attr->value();\
+inline std::string_view XmlName(const rapidxml::xml_base<char>* x)
+{
+	return std::string_view(x->name(), x->name_size());
 }
 
-#define M_RAPID_XML_ATTR_IF_SET_INT(attr, attr_name, target)\
-else if (strcmp(attr->name(), attr_name) == 0) {\
-	target = atoi(attr->value());\
-}
-#define M_RAPID_XML_ATTR_IF_SET_INT_ARRAY(attr, attr_name, target)\
-else if (strcmp(attr->name(), attr_name) == 0) {\
-	std::vector<char> buffer;\
-	buffer.resize(strlen(attr->value()) + 1, 0);\
-	memcpy(buffer.data(), attr->value(), buffer.size()-1);\
-	char* ctx = nullptr;\
-	target[0] = atoi(strtok_s(buffer.data(), ",", &ctx));\
-	for (int i = 1; i < target.size(); i++) {\
-		target[i] = atoi(strtok_s(nullptr, ",", &ctx));\
-	}\
-}
+// perfect hash over a fixed set of names, built at compile time. Find costs one hash and one compare whatever the table size.
+//   static constexpr XmlNameTable names({ "id", "type" });
+//   switch (names.Find(XmlName(attr))) { case names.Index("id"): ... }
+template<std::size_t N>
+class XmlNameTable
+{
+public:
+	consteval XmlNameTable(const char* const (&_names)[N])
+	{
+		for (std::size_t i = 0; i < N; i++) {
+			names[i] = _names[i];
+		}
+		while (!TryBuild()) {
+			seed++;
+		}
+	}
+
+	// index of a name of the table, any other name doesn't compile.
+	consteval int Index(std::string_view name) const
+	{
+		for (std::size_t i = 0; i < N; i++) {
+			if (names[i] == name) {
+				return (int)i;
+			}
+		}
+		throw "not a name of the table";
+	}
+
+	// index of name, -1 when it isn't in the table.
+	constexpr int Find(std::string_view name) const
+	{
+		auto idx = slots[Hash(name, seed) & (SlotCount - 1)];
+		return idx >= 0 && names[idx] == name ? idx : -1;
+	}
+
+private:
+	static constexpr std::size_t SlotCount = std::bit_ceil(N * 2);
+
+	static constexpr uint32_t Hash(std::string_view s, uint32_t seed)
+	{
+		// FNV-1a
+		auto h = 2166136261u ^ (seed * 0x9E3779B9u);
+		for (auto c : s) {
+			h ^= (uint8_t)c;
+			h *= 16777619u;
+		}
+		return h ^ (h >> 16);
+	}
+
+	constexpr bool TryBuild()
+	{
+		slots.fill(-1);
+		for (std::size_t i = 0; i < N; i++) {
+			auto& slot = slots[Hash(names[i], seed) & (SlotCount - 1)];
+			if (slot >= 0) {
+				return false;
+			}
+			slot = (int)i;
+		}
+		return true;
+	}
+
+	std::array<std::string_view, N> names{};
+	std::array<int, SlotCount> slots{};
+	uint32_t seed = 0;
+};
+
+// attribute text with the entities a destructive parse would have translated, the raw text when there are none.
+// like the translated c string, it ends at an encoded nul.
+inline std::string_view XmlValue(const rapidxml::xml_attribute<char>* attr, std::string& scratch)
+{
+	auto raw = std::string_view(attr->value(), attr->value_size());
+	auto amp = raw.find('&');
+	if (amp == std::string_view::npos) {
+		return raw;
+	}
+
+	scratch.assign(raw, 0, amp);
+	for (auto i = amp; i < raw.size();) {
+		if (raw[i] != '&') {
+			scratch += raw[i++];
+			continue;
+		}
+		auto rest = raw.substr(i + 1);
+		if (rest.starts_with("lt;")) { scratch += '<'; i += 4; }
+		else if (rest.starts_with("gt;")) { scratch += '>'; i += 4; }
+		else if (rest.starts_with("amp;")) { scratch += '&'; i += 5; }
+		else if (rest.starts_with("apos;")) { scratch += '\''; i += 6; }
+		else if (rest.starts_with("quot;")) { scratch += '"'; i += 6; }
+		else if (rest.starts_with("#")) {
+			auto hex = rest.size() > 1 && rest[1] == 'x';
+			auto digits_beg = rest.data() + (hex ? 2 : 1);
+			uint32_t code = 0;
+			auto [digits_end, ec] = std::from_chars(digits_beg, rest.data() + rest.size(), code, hex ? 16 : 10);
+			if (ec != std::errc() || digits_end == rest.data() + rest.size() || *digits_end != ';' || code > 0x10FFFF) {
+				throw std::runtime_error("invalid numeric character entity");
+			}
+			if (code < 0x80) {
+				scratch += (char)code;
+			}
+			else if (code < 0x800) {
+				scratch += (char)(0xC0 | (code >> 6));
+				scratch += (char)(0x80 | (code & 0x3F));
+			}
+			else if (code < 0x10000) {
+				scratch += (char)(0xE0 | (code >> 12));
+				scratch += (char)(0x80 | ((code >> 6) & 0x3F));
+				scratch += (char)(0x80 | (code & 0x3F));
+			}
+			else {
+				scratch += (char)(0xF0 | (code >> 18));
+				scratch += (char)(0x80 | ((code >> 12) & 0x3F));
+				scratch += (char)(0x80 | ((code >> 6) & 0x3F));
+				scratch += (char)(0x80 | (code & 0x3F));
+			}
+			i = digits_end - raw.data() + 1;
+		}
+		else {
+			scratch += raw[i++];
+		}
+	}
 
-#define M_RAPID_XML_ATTR_IF_SET_BOOL(attr, attr_name, target)\
-else if (strcmp(attr->name(), attr_name) == 0) {\
-	target = atoi(attr->value()) == 1;\
+	return std::string_view(scratch).substr(0, scratch.find('\0'));
 }
 
 #include "../include/libpng/include/png.h"
@@ -489,9 +726,220 @@ else if (strcmp(attr->name(), attr_name) == 0) {\
 #endif
 
 
+#ifdef _WIN32
+# ifndef WIN32_LEAN_AND_MEAN
+#   define WIN32_LEAN_AND_MEAN
+# endif
+# ifndef VC_EXTRALEAN
+#   define VC_EXTRALEAN
+# endif
+# ifndef NOMINMAX
+#   define NOMINMAX
+# endif
+#include <windows.h>
+
+namespace winext
+{
+	template <std::size_t N = MAX_PATH>
+	inline std::string GetModuleFileName() {
+		char buffer[N];
+		::GetModuleFileName(nullptr, buffer, N);
+		return buffer;
+	}
+}
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// path of the running executable.
+inline fs::path ModulePath()
+{
+#ifdef _WIN32
+	return winext::GetModuleFileName();
+#else
+	std::error_code ec;
+	return fs::read_symlink("/proc/self/exe", ec); // empty if unknown, paths stay relative to the working directory then
+#endif
+}
+
+inline fs::path ToAbsolutePath(const char* src_path)
+{
+	if (fs::path(src_path).is_relative()) {
+		return ModulePath().parent_path().append(src_path);
+	}
+	else {
+		return src_path;
+	}
+}
+
+// read-only view of a whole file.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile()
+	{
+		Close();
+	}
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+#ifdef _WIN32
+	bool Open(const fs::path& file_path)
+	{
+		Close();
+		file = ::CreateFileW(file_path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+		LARGE_INTEGER file_size;
+		if (!::GetFileSizeEx(file, &file_size)) {
+			Close();
+			return false;
+		}
+		size = (std::size_t)file_size.QuadPart;
+		if (size == 0) { // an empty file can't be mapped
+			return true;
+		}
+		mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr) {
+			Close();
+			return false;
+		}
+		data = (const char*)::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (data == nullptr) {
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	void Close()
+	{
+		if (data != nullptr) {
+			::UnmapViewOfFile(data);
+		}
+		if (mapping != nullptr) {
+			::CloseHandle(mapping);
+		}
+		if (file != INVALID_HANDLE_VALUE) {
+			::CloseHandle(file);
+		}
+		data = nullptr;
+		mapping = nullptr;
+		file = INVALID_HANDLE_VALUE;
+		size = 0;
+	}
+#else
+	bool Open(const fs::path& file_path)
+	{
+		Close();
+		file = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (file == -1) {
+			return false;
+		}
+		struct stat file_stat;
+		if (::fstat(file, &file_stat) != 0) {
+			Close();
+			return false;
+		}
+		size = (std::size_t)file_stat.st_size;
+		if (size == 0) { // an empty file can't be mapped
+			return true;
+		}
+		auto view = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (view == MAP_FAILED) {
+			Close();
+			return false;
+		}
+		data = (const char*)view;
+		return true;
+	}
+
+	void Close()
+	{
+		if (data != nullptr) {
+			::munmap((void*)data, size);
+		}
+		if (file != -1) {
+			::close(file);
+		}
+		data = nullptr;
+		file = -1;
+		size = 0;
+	}
+#endif
+
+	const char* Data() const { return data; }
+	std::size_t Size() const { return size; }
+
+	// the rest of the last page reads as zeros, so the view is a c string unless the file fills the page exactly.
+	bool IsNullTerminated() const
+	{
+#ifdef _WIN32
+		SYSTEM_INFO info;
+		::GetSystemInfo(&info);
+		std::size_t page_size = info.dwPageSize;
+#else
+		auto page_size = (std::size_t)::sysconf(_SC_PAGESIZE);
+#endif
+		return data != nullptr && size % page_size != 0;
+	}
+
+private:
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#else
+	int file = -1;
+#endif
+	const char* data = nullptr;
+	std::size_t size = 0;
+};
+
+// parses an xml file straight from its mapping without modifying it.
+// names and values are not terminated, read them with XmlName and XmlValue.
+class XmlFile
+{
+public:
+	explicit XmlFile(const fs::path& file_path)
+	{
+		if (!mapped.Open(file_path)) {
+			throw std::runtime_error("cannot open file");
+		}
+
+		char* text;
+		if (mapped.IsNullTerminated()) {
+			text = const_cast<char*>(mapped.Data());
+		}
+		else {
+			buffer.assign(mapped.Data(), mapped.Data() + mapped.Size());
+			buffer.push_back(0);
+			text = buffer.data();
+		}
+		doc.parse<rapidxml::parse_non_destructive>(text);
+	}
+
+	rapidxml::xml_node<char>* first_node() const
+	{
+		return doc.first_node();
+	}
+
+private:
+	MappedFile mapped;
+	std::vector<char> buffer;
+	rapidxml::xml_document<char> doc;
+};
+
+// decodes a png file to one 8 bit gray value per pixel.
+// gray is used as is, rgb gives its red channel and a fully transparent pixel is 0.
+// data is resized to width * height and keeps its capacity, so a buffer reused between files isn't allocated again.
 class PngReader {
 public:
-	static void Read(fs::path file_path, std::vector<uint8_t>& data)
+	static bool Read(const fs::path& file_path, std::vector<uint8_t>& data)
 	{
 		uint32_t width;
 		uint32_t height;
@@ -500,25 +948,47 @@ public:
 		return Read(file_path, width, height, color_type, bit_depth, data);
 	}
 
-	static void Read(fs::path file_path, uint32_t& width, uint32_t& height, std::vector<uint8_t>& data)
+	static bool Read(const fs::path& file_path, uint32_t& width, uint32_t& height, std::vector<uint8_t>& data)
 	{
 		png_byte color_type;
 		png_byte bit_depth;
 		return Read(file_path, width, height, color_type, bit_depth, data);
 	}
 
-	static void Read(fs::path file_path, uint32_t& width, uint32_t& height, png_byte& color_type, png_byte& bit_depth, std::vector<uint8_t>& data)
+	// color_type and bit_depth are the ones of the file. false when the file can't be read or isn't a valid png.
+	static bool Read(const fs::path& file_path, uint32_t& width, uint32_t& height, png_byte& color_type, png_byte& bit_depth, std::vector<uint8_t>& data)
 	{
-		char header[8];
+		MappedFile file;
+		if (!file.Open(file_path) || file.Size() < 8 || png_sig_cmp((png_const_bytep)file.Data(), 0, 8) != 0) {
+			return false;
+		}
 
-		FILE* fp;
-		fopen_s(&fp, file_path.string().c_str(), "rb");
-		fread(header, 1, 8, fp);
-		auto png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+		struct Source
+		{
+			const uint8_t* pos;
+			std::size_t left;
+		};
+		Source src = { (const uint8_t*)file.Data() + 8, file.Size() - 8 };
+
+		auto png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+		if (png_ptr == nullptr) {
+			return false;
+		}
 		auto info_ptr = png_create_info_struct(png_ptr);
-		setjmp(png_jmpbuf(png_ptr));
+		if (info_ptr == nullptr || setjmp(png_jmpbuf(png_ptr))) {
+			png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
+			return false;
+		}
 
-		png_init_io(png_ptr, fp);
+		png_set_read_fn(png_ptr, &src, [](png_structp png_ptr, png_bytep out, png_size_t size) {
+			auto src = (Source*)png_get_io_ptr(png_ptr);
+			if (src->left < size) {
+				png_error(png_ptr, "unexpected end of file");
+			}
+			memcpy(out, src->pos, size);
+			src->pos += size;
+			src->left -= size;
+		});
 		png_set_sig_bytes(png_ptr, 8);
 		png_read_info(png_ptr, info_ptr);
 
@@ -526,66 +996,74 @@ public:
 		height = png_get_image_height(png_ptr, info_ptr);
 		color_type = png_get_color_type(png_ptr, info_ptr);
 		bit_depth = png_get_bit_depth(png_ptr, info_ptr);
-		auto number_of_passes = png_set_interlace_handling(png_ptr);
-		png_read_update_info(png_ptr, info_ptr);
-
-		setjmp(png_jmpbuf(png_ptr));
 
-		auto row_size = png_get_rowbytes(png_ptr, info_ptr);
-		data.resize(width * height);
+		// libpng brings every format to 8 bit gray or rgb, with alpha when the file has one.
+		if (color_type == PNG_COLOR_TYPE_PALETTE) {
+			png_set_palette_to_rgb(png_ptr);
+			if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS)) {
+				png_set_tRNS_to_alpha(png_ptr);
+			}
+		}
+		if (color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8) {
+			png_set_expand_gray_1_2_4_to_8(png_ptr);
+		}
+		if (bit_depth == 16) {
+			png_set_strip_16(png_ptr);
+		}
+		auto passes = png_set_interlace_handling(png_ptr);
+		png_read_update_info(png_ptr, info_ptr);
 
-		std::vector<uint8_t> row_bytes;
-		row_bytes.resize(row_size);
-		for (uint32_t y = 0; y < height; y++) {
-			png_read_row(png_ptr, row_bytes.data(), nullptr);
-			if (color_type == PNG_COLOR_TYPE_GRAY) {
-				for (uint32_t i = 0; i < width; i++) {
-					data[y * width + i] = row_bytes[i];
-				}
+		auto channels = png_get_channels(png_ptr, info_ptr);
+		data.resize((std::size_t)width * height);
+		if (channels == 1) {
+			// gray rows go straight into data.
+			thread_local std::vector<png_bytep> rows;
+			rows.resize(height);
+			for (uint32_t y = 0; y < height; y++) {
+				rows[y] = data.data() + (std::size_t)y * width;
+			}
+			png_read_image(png_ptr, rows.data());
+		}
+		else if (passes == 1) {
+			// each row is decoded into one buffer kept per thread and folded into data.
+			thread_local std::vector<uint8_t> row;
+			row.resize((std::size_t)width * channels);
+			for (uint32_t y = 0; y < height; y++) {
+				png_read_row(png_ptr, row.data(), nullptr);
+				FoldRow(row.data(), channels, width, data.data() + (std::size_t)y * width);
 			}
-			else if (color_type == PNG_COLOR_TYPE_RGB) {
-				for (uint32_t i = 0; i < width * 3; i += 3) {
-					data[y * width + i / 3] = row_bytes[i];
-				}
+		}
+		else {
+			// the passes of an interlaced file fill the rows a bit at a time, so the whole image is decoded first.
+			thread_local std::vector<uint8_t> image;
+			thread_local std::vector<png_bytep> rows;
+			auto row_size = (std::size_t)width * channels;
+			image.resize(row_size * height);
+			rows.resize(height);
+			for (uint32_t y = 0; y < height; y++) {
+				rows[y] = image.data() + y * row_size;
 			}
-			else if (color_type == PNG_COLOR_TYPE_RGB_ALPHA) {
-				for (uint32_t i = 0; i < width * 4; i += 4) {
-					data[y * width + i / 4] = row_bytes[i + 3] == 0 ? 0 : row_bytes[i];
-				}
+			png_read_image(png_ptr, rows.data());
+			for (uint32_t y = 0; y < height; y++) {
+				FoldRow(rows[y], channels, width, data.data() + (std::size_t)y * width);
 			}
 		}
-		fclose(fp);
-	}
-};
-
+		png_read_end(png_ptr, nullptr);
+		png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
 
-# ifndef WIN32_LEAN_AND_MEAN
-#   define WIN32_LEAN_AND_MEAN
-# endif
-# ifndef VC_EXTRALEAN
-#   define VC_EXTRALEAN
-# endif
-# ifndef NOMINMAX
-#   define NOMINMAX
-# endif
-#include <windows.h>
-
-namespace winext
-{
-	template <std::size_t N = MAX_PATH>
-	inline std::string GetModuleFileName() {
-		char buffer[N];
-		::GetModuleFileName(nullptr, buffer, N);
-		return buffer;
+		return true;
 	}
-}
 
-inline fs::path ToAbsolutePath(const char* src_path)
-{
-	if (fs::path(src_path).is_relative()) {
-		return fs::path(winext::GetModuleFileName()).parent_path().append(src_path);
-	}
-	else {
-		return src_path;
+private:
+	// first channel of each pixel (red for rgb), 0 when it is fully transparent.
+	// png_set_rgb_to_gray applies the file gamma even with a red only weight, and no transform zeroes just the fully
+	// transparent pixels, so the fold is done here.
+	static void FoldRow(const uint8_t* src, png_byte channels, uint32_t width, uint8_t* dst)
+	{
+		auto has_alpha = (channels % 2) == 0;
+		for (uint32_t x = 0; x < width; x++) {
+			auto pixel = src + (std::size_t)x * channels;
+			dst[x] = has_alpha && pixel[channels - 1] == 0 ? 0 : pixel[0];
+		}
 	}
-}
\ No newline at end of file
+};
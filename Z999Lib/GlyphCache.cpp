@@ -0,0 +1,95 @@
+#include "GlyphCache.hpp"
+
+bool GlyphCache::Open(const fs::path& file_path)
+{
+	Close();
+	if (!mapped.Open(file_path) || mapped.Size() < sizeof(Header)) {
+		return false;
+	}
+
+	auto data = mapped.Data();
+	auto size = (uint64_t)mapped.Size();
+	Header header;
+	memcpy(&header, data, sizeof(Header));
+	if (memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version) {
+		Close();
+		return false;
+	}
+
+	uint64_t pos = sizeof(Header);
+	if (header.glyph_count > (size - pos) / sizeof(GlyphRecord)) {
+		Close();
+		return false;
+	}
+	std::span<const GlyphRecord> records((const GlyphRecord*)(data + pos), (std::size_t)header.glyph_count);
+	pos += header.glyph_count * sizeof(GlyphRecord);
+	if (header.pixel_data_size > size - pos) {
+		Close();
+		return false;
+	}
+
+	// every record is checked once here, Find doesn't check again.
+	for (std::size_t i = 0; i < records.size(); i++) {
+		auto& r = records[i];
+		if (r.offset > header.pixel_data_size || (uint64_t)r.width * r.height > header.pixel_data_size - r.offset ||
+			(i > 0 && !(records[i - 1].key < r.key))) {
+			Close();
+			return false;
+		}
+	}
+
+	glyphs = records;
+	pixel_data = (const uint8_t*)data + pos;
+	return true;
+}
+
+void GlyphCache::Close()
+{
+	glyphs = {};
+	pixel_data = nullptr;
+	mapped.Close();
+}
+
+std::optional<GlyphCache::Glyph> GlyphCache::Find(const Key& key) const
+{
+	auto it = std::lower_bound(glyphs.begin(), glyphs.end(), key, [](const GlyphRecord& r, const Key& k) {
+		return r.key < k;
+	});
+	if (it == glyphs.end() || it->key != key) {
+		return std::nullopt;
+	}
+	return Glyph{ it->width, it->height, std::span<const uint8_t>(pixel_data + it->offset, it->width * it->height) };
+}
+
+bool GlyphCache::Write(const fs::path& file_path, std::vector<Entry> entries)
+{
+	std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+	entries.erase(std::unique(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.key == b.key; }), entries.end());
+
+	std::vector<GlyphRecord> records;
+	records.reserve(entries.size());
+	uint64_t pixel_data_size = 0;
+	for (auto& e : entries) {
+		GlyphRecord r{};
+		r.key = e.key;
+		r.offset = pixel_data_size;
+		r.width = e.glyph.width;
+		r.height = e.glyph.height;
+		records.push_back(r);
+		pixel_data_size += e.glyph.pixels.size();
+	}
+
+	Header header;
+	memcpy(header.magic, Magic, sizeof(Magic));
+	header.version = Version;
+	header.glyph_count = records.size();
+	header.pixel_data_size = pixel_data_size;
+
+	std::ofstream ofs(file_path, std::ios::binary);
+	ofs.write((const char*)&header, sizeof(header));
+	ofs.write((const char*)records.data(), records.size() * sizeof(GlyphRecord));
+	for (auto& e : entries) {
+		ofs.write((const char*)e.glyph.pixels.data(), e.glyph.pixels.size());
+	}
+	return !ofs.bad();
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Common.hpp"
+
+// finished glyph bitmaps of an earlier sir-generate-font-data run, read straight from the mapping.
+// a glyph is one plane of a font node, found by the hash of the BMFont files it was cut from, its codepoint and the plane.
+//
+// layout (little endian) :
+//   Header
+//   GlyphRecord[glyph_count]  sorted by key, looked up with a binary search
+//   pixel data                width x height bytes per glyph
+class GlyphCache
+{
+public:
+	static constexpr char FileName[] = "font-glyphs.cache";
+	static constexpr char Magic[4] = { 'G', 'L', 'Y', 'C' };
+	static constexpr uint32_t Version = 1;
+
+	struct Key
+	{
+		uint64_t font_hash;
+		uint32_t codepoint;
+		uint32_t plane;
+
+		auto operator<=>(const Key&) const = default;
+	};
+
+	struct Header
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t glyph_count;
+		uint64_t pixel_data_size;
+	};
+	struct GlyphRecord
+	{
+		Key key;
+		uint64_t offset;
+		uint8_t width;
+		uint8_t height;
+		uint8_t reserved[6];
+	};
+
+	struct Glyph
+	{
+		uint8_t width;
+		uint8_t height;
+		std::span<const uint8_t> pixels;
+	};
+	struct Entry
+	{
+		Key key;
+		Glyph glyph;
+	};
+
+	// false when there is no cache yet or it can't be used, the cache is empty then.
+	bool Open(const fs::path& file_path);
+	// the mapping has to be gone before the file is written again.
+	void Close();
+
+	std::size_t Count() const { return glyphs.size(); }
+	std::optional<Glyph> Find(const Key& key) const;
+
+	// entries in any order, the pixels are only read.
+	static bool Write(const fs::path& file_path, std::vector<Entry> entries);
+
+private:
+	MappedFile mapped;
+	std::span<const GlyphRecord> glyphs;
+	const uint8_t* pixel_data = nullptr;
+};
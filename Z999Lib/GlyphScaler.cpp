@@ -0,0 +1,154 @@
+#include "GlyphScaler.hpp"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define M_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+void GlyphScaler::Scale(const uint8_t* src, std::size_t w, std::size_t h, uint8_t* dst) const
+{
+	if (w == 0 || h == 0) {
+		memset(dst, 0, dst_size * dst_size);
+		return;
+	}
+
+	auto& table = GetTable(w, h);
+	if (filter == Filter::Box) {
+		ScaleBox(table, src, w, h, dst);
+	}
+	else {
+		ScaleNearest(table, src, w, dst);
+	}
+}
+
+const GlyphScaler::Table& GlyphScaler::GetTable(std::size_t w, std::size_t h) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto& table = tables[(uint32_t)((w << 8) | h)];
+	if (!table) {
+		// both axes are scaled by the longer side so the glyph keeps its aspect.
+		auto max_value = std::max(w, h);
+		table = std::make_unique<Table>();
+		if (filter == Filter::Box) {
+			BuildBox(max_value, w, table->x);
+			BuildBox(max_value, h, table->y);
+		}
+		else {
+			BuildNearest(max_value, w, table->x);
+			BuildNearest(max_value, h, table->y);
+		}
+	}
+	return *table;
+}
+
+void GlyphScaler::BuildNearest(std::size_t max_value, std::size_t size, Axis& axis) const
+{
+	// same rounding as the per pixel version, so the output doesn't change.
+	auto ratio = (max_value * 100 / dst_size) * 0.01f;
+	axis.nearest.resize(dst_size);
+	for (std::size_t i = 0; i < dst_size; i++) {
+		axis.nearest[i] = std::min<uint8_t>((uint8_t)(i * ratio), (uint8_t)(size - 1));
+	}
+}
+
+void GlyphScaler::BuildBox(std::size_t max_value, std::size_t size, Axis& axis) const
+{
+	// destination pixel i covers [i, i + 1) * max_value / dst_size of the source.
+	// a source pixel gets the rounded share of the covered range, taken from running totals so the shares add up to WeightOne.
+	// the range past a shorter side repeats its last pixel, like the nearest table clamps to it.
+	axis.taps.resize(dst_size);
+	axis.tap_data.clear();
+	for (std::size_t i = 0; i < dst_size; i++) {
+		auto begin = i * max_value;
+		auto end = (i + 1) * max_value;
+		auto& taps = axis.taps[i];
+		taps.begin = (uint32_t)axis.tap_data.size();
+
+		auto func_total = [&](std::size_t pos) {
+			return (uint32_t)(((pos - begin) * WeightOne + max_value / 2) / max_value);
+		};
+		for (auto s = begin / dst_size; s * dst_size < end; s++) {
+			auto covered_begin = std::max(s * dst_size, begin);
+			auto covered_end = std::min((s + 1) * dst_size, end);
+			auto weight = func_total(covered_end) - func_total(covered_begin);
+			if (weight == 0) {
+				continue;
+			}
+			auto idx = (uint16_t)std::min(s, size - 1);
+			if (axis.tap_data.size() > taps.begin && axis.tap_data.back().idx == idx) {
+				axis.tap_data.back().weight += (uint16_t)weight;
+			}
+			else {
+				axis.tap_data.push_back({ idx, (uint16_t)weight });
+			}
+		}
+		taps.count = (uint32_t)axis.tap_data.size() - taps.begin;
+	}
+}
+
+void GlyphScaler::ScaleNearest(const Table& table, const uint8_t* src, std::size_t w, uint8_t* dst) const
+{
+	auto xs = table.x.nearest.data();
+	for (std::size_t y = 0; y < dst_size; y++) {
+		auto src_row = src + table.y.nearest[y] * w;
+		auto dst_row = dst + y * dst_size;
+		for (std::size_t x = 0; x < dst_size; x++) {
+			dst_row[x] = src_row[xs[x]];
+		}
+	}
+}
+
+void GlyphScaler::ScaleBox(const Table& table, const uint8_t* src, std::size_t w, std::size_t h, uint8_t* dst) const
+{
+	// horizontal pass into 16 bit sums (at most 255 * WeightOne), one row per source row.
+	thread_local std::vector<uint16_t> rows;
+	rows.resize(h * dst_size);
+	for (std::size_t y = 0; y < h; y++) {
+		auto src_row = src + y * w;
+		auto row = rows.data() + y * dst_size;
+		for (std::size_t x = 0; x < dst_size; x++) {
+			auto& taps = table.x.taps[x];
+			uint32_t sum = 0;
+			for (auto t = taps.begin; t < taps.begin + taps.count; t++) {
+				sum += src_row[table.x.tap_data[t].idx] * table.x.tap_data[t].weight;
+			}
+			row[x] = (uint16_t)sum;
+		}
+	}
+
+	// vertical pass, a weighted sum of whole rows.
+	for (std::size_t y = 0; y < dst_size; y++) {
+		auto& taps = table.y.taps[y];
+		auto first_tap = table.y.tap_data.data() + taps.begin;
+		auto last_tap = first_tap + taps.count;
+		auto dst_row = dst + y * dst_size;
+
+		std::size_t x = 0;
+#ifdef M_USE_SSE2
+		auto half = _mm_set1_epi32(WeightOne * WeightOne / 2);
+		for (; x + 8 <= dst_size; x += 8) {
+			auto sum_lo = half;
+			auto sum_hi = half;
+			for (auto t = first_tap; t < last_tap; t++) {
+				auto v = _mm_loadu_si128((const __m128i*)(rows.data() + t->idx * dst_size + x));
+				auto weight = _mm_set1_epi16((short)t->weight);
+				auto lo = _mm_mullo_epi16(v, weight);
+				auto hi = _mm_mulhi_epu16(v, weight);
+				sum_lo = _mm_add_epi32(sum_lo, _mm_unpacklo_epi16(lo, hi));
+				sum_hi = _mm_add_epi32(sum_hi, _mm_unpackhi_epi16(lo, hi));
+			}
+			sum_lo = _mm_srli_epi32(sum_lo, 16);
+			sum_hi = _mm_srli_epi32(sum_hi, 16);
+			auto packed = _mm_packs_epi32(sum_lo, sum_hi);
+			_mm_storel_epi64((__m128i*)(dst_row + x), _mm_packus_epi16(packed, packed));
+		}
+#endif
+		for (; x < dst_size; x++) {
+			uint32_t sum = WeightOne * WeightOne / 2;
+			for (auto t = first_tap; t < last_tap; t++) {
+				sum += rows[t->idx * dst_size + x] * t->weight;
+			}
+			dst_row[x] = (uint8_t)(sum >> 16);
+		}
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Common.hpp"
+
+// rescales 8 bit glyph bitmaps into a square of a fixed size.
+// the sampling tables only depend on the source size, so each size is worked out once and shared by every glyph of that size.
+// Scale can be called from several threads at once.
+class GlyphScaler
+{
+public:
+	enum class Filter
+	{
+		Nearest, // the sampling ReduceKanjiSize always had
+		Box,     // area average, keeps thin strokes at small sizes
+	};
+
+	GlyphScaler(std::size_t _dst_size, Filter _filter) : dst_size(_dst_size), filter(_filter) {}
+
+	std::size_t DstSize() const { return dst_size; }
+
+	// src is w x h, dst gets DstSize() x DstSize() pixels.
+	void Scale(const uint8_t* src, std::size_t w, std::size_t h, uint8_t* dst) const;
+
+private:
+	// source pixels of one destination pixel along an axis, weights add up to WeightOne.
+	struct Taps
+	{
+		uint32_t begin;
+		uint32_t count;
+	};
+	struct Tap
+	{
+		uint16_t idx;
+		uint16_t weight;
+	};
+	struct Axis
+	{
+		std::vector<uint8_t> nearest;
+		std::vector<Taps> taps;
+		std::vector<Tap> tap_data;
+	};
+	struct Table
+	{
+		Axis x;
+		Axis y;
+	};
+
+	static constexpr uint32_t WeightOne = 256;
+
+	const Table& GetTable(std::size_t w, std::size_t h) const;
+	void BuildNearest(std::size_t max_value, std::size_t size, Axis& axis) const;
+	void BuildBox(std::size_t max_value, std::size_t size, Axis& axis) const;
+
+	void ScaleNearest(const Table& table, const uint8_t* src, std::size_t w, uint8_t* dst) const;
+	void ScaleBox(const Table& table, const uint8_t* src, std::size_t w, std::size_t h, uint8_t* dst) const;
+
+	std::size_t dst_size;
+	Filter filter;
+
+	mutable std::mutex mutex;
+	mutable std::map<uint32_t, std::unique_ptr<Table>> tables; // key (w << 8) | h
+};
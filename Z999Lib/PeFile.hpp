@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Common.hpp"
+
+struct PeFile
+{
+	static constexpr uint32_t SCN_CNT_CODE = 0x00000020;
+	static constexpr uint32_t SCN_CNT_INITIALIZED_DATA = 0x00000040;
+	static constexpr uint32_t SCN_MEM_DISCARDABLE = 0x02000000;
+	static constexpr uint32_t SCN_MEM_EXECUTE = 0x20000000;
+
+	struct Section
+	{
+		std::string name;
+		uint32_t virtual_size;
+		uint32_t virtual_address;
+		uint32_t raw_size;
+		uint32_t raw_offset;
+		uint32_t characteristics;
+
+		// .rdata/.data, where the sjis string tables live.
+		bool IsStringData() const
+		{
+			if ((characteristics & SCN_CNT_INITIALIZED_DATA) == 0) {
+				return false;
+			}
+			if (characteristics & (SCN_CNT_CODE | SCN_MEM_EXECUTE | SCN_MEM_DISCARDABLE)) {
+				return false;
+			}
+			return name != ".rsrc" && name != ".reloc";
+		}
+	};
+
+	uint64_t image_base = 0;
+	std::vector<Section> sections;
+
+	bool Read(std::span<char> buffer)
+	{
+		try {
+			MemReader reader(buffer);
+			if (reader.Read<uint16_t>() != 0x5A4D) { // MZ
+				return false;
+			}
+			reader.Seek(0x3C);
+			reader.Seek(reader.Read<uint32_t>());
+			if (reader.Read<uint32_t>() != 0x00004550) { // PE\0\0
+				return false;
+			}
+
+			reader.Forward(2); // machine
+			auto section_count = reader.Read<uint16_t>();
+			reader.Forward(4 + 4 + 4); // timestamp, symbol table, symbol count
+			auto optional_header_size = reader.Read<uint16_t>();
+			reader.Forward(2); // characteristics
+
+			auto optional_header_pos = reader.CurrPos();
+			auto magic = reader.Read<uint16_t>();
+			if (magic == 0x10B) { // PE32
+				reader.Seek(optional_header_pos + 28);
+				image_base = reader.Read<uint32_t>();
+			}
+			else if (magic == 0x20B) { // PE32+
+				reader.Seek(optional_header_pos + 24);
+				image_base = reader.Read<uint64_t>();
+			}
+			else {
+				return false;
+			}
+
+			reader.Seek(optional_header_pos + optional_header_size);
+			sections.clear();
+			sections.reserve(section_count);
+			for (int i = 0; i < section_count; i++) {
+				Section sec{};
+				auto name = reader.ReadArray<char, 8>();
+				sec.name.assign(name.data(), strnlen(name.data(), name.size()));
+				sec.virtual_size = reader.Read<uint32_t>();
+				sec.virtual_address = reader.Read<uint32_t>();
+				sec.raw_size = reader.Read<uint32_t>();
+				sec.raw_offset = reader.Read<uint32_t>();
+				reader.Forward(4 + 4 + 2 + 2); // relocations, line numbers
+				sec.characteristics = reader.Read<uint32_t>();
+				sections.push_back(sec);
+			}
+		}
+		catch (const std::exception& e) {
+			return false;
+		}
+
+		return true;
+	}
+
+	const Section* FindSection(std::size_t file_offset) const
+	{
+		for (auto& sec : sections) {
+			if (file_offset >= sec.raw_offset && file_offset < (std::size_t)sec.raw_offset + sec.raw_size) {
+				return &sec;
+			}
+		}
+		return nullptr;
+	}
+
+	uint64_t OffsetToVA(std::size_t file_offset) const
+	{
+		auto sec = FindSection(file_offset);
+		if (sec == nullptr) {
+			return 0;
+		}
+		return image_base + sec->virtual_address + (file_offset - sec->raw_offset);
+	}
+};
@@ -1,6 +1,11 @@
 #pragma once
 
 #include "Common.hpp"
+#include "ThreadPool.hpp"
+#include "GlyphScaler.hpp"
+
+using SirString = InternedString<char>;
+using SirWString = InternedString<wchar_t>;
 
 struct SirBase
 {
@@ -14,11 +19,11 @@ struct SirDlg : public SirBase
 	static constexpr char XmlExtension[] = ".dlg.xml";
 
 	struct Node {
-		std::string id__;
-		std::string type;
-		std::string name;
+		SirString id__;
+		SirString type;
+		SirString name;
 		std::string text;
-		std::wstring patch_name;
+		SirWString patch_name;
 		std::wstring patch_text;
 
 		bool Equal(const Node& other) const {
@@ -48,7 +53,7 @@ struct SirFont : public SirBase
 		std::string patch_keycode;
 		uint8_t wsize[2] = {};
 		uint8_t hsize[2] = {};
-		std::vector<uint8_t> data[2];
+		uint32_t offset[2] = {}; // where the wsize x hsize pixels start in the plane arena of the font
 
 		std::string SjisString() const {
 			std::string s;
@@ -86,36 +91,130 @@ struct SirFont : public SirBase
 		}
 	};
 
-	void ReduceKanjiSize(const std::wstring& excepts, std::size_t mod_size)
+	std::span<uint8_t> Pixels(const Node& n, int plane)
 	{
-		for (auto& n : nodes) {
+		return std::span<uint8_t>(pixels[plane].data() + n.offset[plane], n.wsize[plane] * n.hsize[plane]);
+	}
+	std::span<const uint8_t> Pixels(const Node& n, int plane) const
+	{
+		return std::span<const uint8_t>(pixels[plane].data() + n.offset[plane], n.wsize[plane] * n.hsize[plane]);
+	}
+
+	// zero filled room for the current size of a plane of n at the end of the arena.
+	// the arena may move, so spans taken before don't survive this.
+	std::span<uint8_t> AllocPixels(Node& n, int plane)
+	{
+		n.offset[plane] = (uint32_t)pixels[plane].size();
+		pixels[plane].resize(pixels[plane].size() + n.wsize[plane] * n.hsize[plane], 0);
+		return Pixels(n, plane);
+	}
+
+	// a copy of a node of another font, its pixels appended to the arenas of this one.
+	std::shared_ptr<Node> Import(const SirFont& src, const Node& n)
+	{
+		auto copy = std::make_shared<Node>(n);
+		if (&src != this) {
+			for (int i = 0; i < 2; i++) {
+				auto src_pixels = src.Pixels(n, i);
+				std::copy(src_pixels.begin(), src_pixels.end(), AllocPixels(*copy, i).begin());
+			}
+		}
+		return copy;
+	}
+
+	// nodes with the same bitmap in a plane are pointed at one copy of it, blank glyphs and repeated boxes end up once in the arena.
+	// the pixels of a node may be shared afterwards, so they are only written through a fresh AllocPixels.
+	void SharePixels()
+	{
+		auto count = nodes.size();
+		std::vector<uint64_t> hashes(count);
+		for (int i = 0; i < 2; i++) {
+			ThreadPool::Shared().ParallelFor(count, [&](std::size_t idx) {
+				auto& n = *nodes[idx];
+				auto src = Pixels(n, i);
+				uint8_t size[2] = { n.wsize[i], n.hsize[i] };
+				hashes[idx] = HashBytes(src.data(), src.size(), HashBytes(size, sizeof(size)));
+			});
+
+			std::vector<uint8_t> shared;
+			shared.reserve(pixels[i].size());
+			std::unordered_multimap<uint64_t, const Node*> kept; // hash -> node whose bitmap is already in shared
+			for (std::size_t idx = 0; idx < count; idx++) {
+				auto& n = *nodes[idx];
+				auto src = Pixels(n, i);
+				auto [first, last] = kept.equal_range(hashes[idx]);
+				auto same = std::find_if(first, last, [&](const auto& k) {
+					auto& o = *k.second;
+					return o.wsize[i] == n.wsize[i] && o.hsize[i] == n.hsize[i] &&
+						(src.empty() || memcmp(shared.data() + o.offset[i], src.data(), src.size()) == 0);
+				});
+				if (same != last) {
+					n.offset[i] = same->second->offset[i];
+				}
+				else {
+					n.offset[i] = (uint32_t)shared.size();
+					shared.insert(shared.end(), src.begin(), src.end());
+					kept.emplace(hashes[idx], &n);
+				}
+			}
+			pixels[i].swap(shared);
+		}
+	}
+
+	void ReduceKanjiSize(const std::wstring& excepts, const GlyphScaler& scaler)
+	{
+		auto mod_size = scaler.DstSize();
+		auto count = nodes.size();
+
+		auto func_is_kanji = [&excepts](const Node& n) {
 			// skip ansi & jp symbols
-			if (n->keycode[1] == 0 || (uint8_t)n->keycode[1] == 0x81 || (uint8_t)n->keycode[1] == 0x84) {
-				continue;
+			if (n.keycode[1] == 0 || (uint8_t)n.keycode[1] == 0x81 || (uint8_t)n.keycode[1] == 0x84) {
+				return false;
 			}
-			if (!excepts.empty() && excepts.find(n->Unicode()) != std::string::npos) {
-				continue;
+			return excepts.empty() || excepts.find(n.Unicode()) == std::string::npos;
+		};
+
+		// the arenas are laid out again with the new sizes, dropping pixels no node uses anymore.
+		std::vector<uint8_t> is_kanji(count, 0);
+		std::vector<Node> org_nodes;
+		org_nodes.reserve(count);
+		std::array<std::size_t, 2> total_size = {};
+		for (std::size_t idx = 0; idx < count; idx++) {
+			auto& n = nodes[idx];
+			org_nodes.push_back(*n);
+			if (func_is_kanji(*n)) {
+				is_kanji[idx] = 1;
+				for (int i = 0; i < 2; i++) {
+					n->wsize[i] = (uint8_t)mod_size;
+					n->hsize[i] = (uint8_t)mod_size;
+				}
+			}
+			for (int i = 0; i < 2; i++) {
+				n->offset[i] = (uint32_t)total_size[i];
+				total_size[i] += n->wsize[i] * n->hsize[i];
 			}
+		}
+
+		std::array<std::vector<uint8_t>, 2> org_pixels;
+		for (int i = 0; i < 2; i++) {
+			org_pixels[i].swap(pixels[i]);
+			pixels[i].resize(total_size[i]);
+		}
 
+		ThreadPool::Shared().ParallelFor(count, [&](std::size_t idx) {
+			auto& org = org_nodes[idx];
+			auto& n = *nodes[idx];
 			for (int i = 0; i < 2; i++) {
-				auto max_value = std::max<uint8_t>(n->wsize[i], n->hsize[i]);
-				auto ratio = (max_value * 100 / mod_size) * 0.01f;
-
-				std::vector<uint8_t> data;
-				data.resize(mod_size * mod_size);
-				for (int y = 0; y < mod_size; y++) {
-					auto orgy = std::min<uint8_t>((uint8_t)(y * ratio), n->hsize[i] - 1);
-					for (int x = 0; x < mod_size; x++) {
-						auto orgx = std::min<uint8_t>((uint8_t)(x * ratio), n->wsize[i] - 1);
-						data[y * mod_size + x] = n->data[i][orgy * n->wsize[i] + orgx];
-					}
+				auto src = org_pixels[i].data() + org.offset[i];
+				auto dst = Pixels(n, i);
+				if (is_kanji[idx]) {
+					scaler.Scale(src, org.wsize[i], org.hsize[i], dst.data());
+				}
+				else {
+					std::copy(src, src + dst.size(), dst.begin());
 				}
-
-				n->wsize[i] = mod_size;
-				n->hsize[i] = mod_size;
-				n->data[i].swap(data);
 			}
-		}
+		});
 	}
 
 	void RemoveKanji(const std::wstring& excepts)
@@ -130,6 +229,7 @@ struct SirFont : public SirBase
 
 	std::vector<std::shared_ptr<Node>> nodes;
 	std::array<uint32_t, 3> footer_unknown_values = {};
+	std::array<std::vector<uint8_t>, 2> pixels; // default and border glyphs, back to back
 };
 
 struct SirName : public SirBase
@@ -137,9 +237,9 @@ struct SirName : public SirBase
 	static constexpr char XmlExtension[] = ".name.xml";
 
 	struct Node {
-		std::string key_name;
+		SirString key_name;
 		std::string name;
-		std::string key_msg;
+		SirString key_msg;
 		std::string msg;
 		std::array<uint32_t, 2> unknown_value;
 
@@ -168,7 +268,7 @@ struct SirItem : public SirBase
 	{
 		struct Item
 		{
-			std::string key;
+			SirString key;
 			std::string text1;
 			std::string text2;
 			std::array<int32_t, 4> unknowns;
@@ -191,7 +291,7 @@ struct SirItem : public SirBase
 			return name == other.name;
 		}
 
-		std::string name;
+		SirString name;
 		std::vector<std::shared_ptr<Item>> items;
 
 		std::size_t Size() const
@@ -222,7 +322,7 @@ struct SirMsg : public SirBase
 
 	struct Node
 	{
-		std::string key;
+		SirString key;
 		std::vector<std::string> texts;
 		std::vector<std::wstring> patch_texts;
 
@@ -262,7 +362,7 @@ struct SirDesc : public SirBase
 	struct Node
 	{
 		std::vector<uint8_t> bytes;
-		std::string id;
+		SirString id;
 	};
 
 	struct Text
@@ -282,7 +382,7 @@ struct SirDesc : public SirBase
 			if (nodes[0]->id == "~OP.MapIn")
 				return false;
 
-			if (nodes[0]->id.find("MapIn") != std::string::npos && nodes[1]->id.find("MapStart") != std::string::npos)
+			if (nodes[0]->id.String().find("MapIn") != std::string::npos && nodes[1]->id.String().find("MapStart") != std::string::npos)
 				return true;
 		}
 		return false;
@@ -305,17 +405,17 @@ struct SirFChart : public SirBase
 
 	struct Node
 	{
-		std::string id1;
-		std::string id2;
+		SirString id1;
+		SirString id2;
 		std::string name_jp;
 		std::string filename;
 		std::string name;
 
 		std::string text;
 		std::string desc_jp;
-		std::string type_id1;
-		std::string command1;
-		std::string type_id2;
+		SirString type_id1;
+		SirString command1;
+		SirString type_id2;
 
 		std::wstring patch_text;
 
@@ -347,8 +447,8 @@ struct SirFChart : public SirBase
 
 		struct Item
 		{
-			std::string id1;
-			std::string id2;
+			SirString id1;
+			SirString id2;
 			std::string name_jp;
 			std::string filename;
 			std::string name;
@@ -391,8 +491,8 @@ struct SirDoc : public SirBase
 
 	struct Node
 	{
-		std::string key1;
-		std::string key2;
+		SirString key1;
+		SirString key2;
 		std::string text1;
 		std::string text2;
 		std::wstring patch_text1;
@@ -446,7 +546,7 @@ struct SirMap : public SirBase
 	{
 		struct Item
 		{
-			std::string key;
+			SirString key;
 			std::string text;
 			std::string desc;
 			std::array<uint32_t, 3> unknowns;
@@ -464,7 +564,7 @@ struct SirMap : public SirBase
 					sizeof(uint32_t) * 3;
 			}
 		};
-		std::string name;
+		SirString name;
 		std::vector<std::shared_ptr<Item>> items;
 
 		bool Equal(const Node& other) const {
@@ -504,7 +604,7 @@ struct SirCredit : SirBase
 				return text.length() + 1;
 			}
 		};
-		std::string name;
+		SirString name;
 		std::vector<std::shared_ptr<Item>> items;
 
 		bool Equal(const Node& other) const {
@@ -532,12 +632,12 @@ struct SirRoom : SirBase
 	{
 		struct Item
 		{
-			std::string id;
+			SirString id;
 			std::string text;
 			std::wstring patch_text;
-			std::string key;
-			std::string in;
-			std::string out;
+			SirString key;
+			SirString in;
+			SirString out;
 
 			bool Equal(const Item& other) const {
 				return id == other.id;
@@ -552,7 +652,7 @@ struct SirRoom : SirBase
 					out.length() + 1;
 			}
 		};
-		std::string name;
+		SirString name;
 		std::vector<std::shared_ptr<Item>> items;
 
 		bool Equal(const Node& other) const {
@@ -1,51 +1,168 @@
 #include "SirPngWriter.hpp"
 
-void SirPngWriter::Write(const SirFont& sir, int data_idx, fs::path file_path)
+SirPngWriter::Atlas SirPngWriter::Layout(const SirFont& sir, int data_idx)
 {
-	uint8_t data_width = 0;
-	uint8_t data_height = 0;
-	for (auto& n : sir.nodes) {
-		data_width = std::max(n->wsize[data_idx], data_width);
-		data_height = std::max(n->hsize[data_idx], data_height);
+	// skyline packing : the glyphs go tallest first, each one to the lowest spot along the top edge
+	// of the glyphs already placed, the leftmost of equal ones.
+	auto nsize = sir.nodes.size();
+	Atlas atlas;
+	atlas.positions.resize(nsize);
+
+	// nodes sharing a range of the arena (SirFont::SharePixels) share their spot in the png as well.
+	std::unordered_map<uint64_t, uint32_t> placed; // offset, w, h -> first node
+	std::vector<std::pair<uint32_t, uint32_t>> shared; // node, first node with its pixels
+
+	uint64_t area = 0;
+	uint32_t max_width = 1;
+	std::vector<uint32_t> order;
+	order.reserve(nsize);
+	for (uint32_t i = 0; i < nsize; i++) {
+		auto& n = sir.nodes[i];
+		if (n->wsize[data_idx] == 0 || n->hsize[data_idx] == 0) {
+			continue;
+		}
+		auto key = ((uint64_t)n->offset[data_idx] << 16) | (n->wsize[data_idx] << 8) | n->hsize[data_idx];
+		auto [it, inserted] = placed.try_emplace(key, i);
+		if (!inserted) {
+			shared.emplace_back(i, it->second);
+			continue;
+		}
+		area += n->wsize[data_idx] * n->hsize[data_idx];
+		max_width = std::max<uint32_t>(max_width, n->wsize[data_idx]);
+		order.push_back(i);
 	}
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t l, uint32_t r) {
+		auto& ln = sir.nodes[l];
+		auto& rn = sir.nodes[r];
+		if (ln->hsize[data_idx] != rn->hsize[data_idx]) {
+			return ln->hsize[data_idx] > rn->hsize[data_idx];
+		}
+		return ln->wsize[data_idx] > rn->wsize[data_idx];
+	});
 
-	auto nsize = sir.nodes.size();
-	auto wcount = (int)sqrt(nsize); wcount = wcount % 2 == 1 ? wcount + 1 : wcount;
-	auto hcount = ((nsize / wcount) + (nsize % wcount > 0 ? 1 : 0));
-	auto png_width = data_width * wcount;
-	auto png_height = data_height * hcount;
+	atlas.width = std::max(max_width, (uint32_t)std::ceil(std::sqrt(area * 1.05)));
+
+	struct Segment
+	{
+		uint32_t x;
+		uint32_t y;
+		uint32_t width;
+	};
+	std::vector<Segment> skyline = { { 0, 0, atlas.width } };
+
+	for (auto idx : order) {
+		uint32_t w = sir.nodes[idx]->wsize[data_idx];
+		uint32_t h = sir.nodes[idx]->hsize[data_idx];
+
+		std::size_t best = skyline.size();
+		uint32_t best_y = 0;
+		for (std::size_t i = 0; i < skyline.size(); i++) {
+			auto x = skyline[i].x;
+			if (x + w > atlas.width) {
+				break;
+			}
+			// the glyph rests on the highest segment under it
+			uint32_t y = 0;
+			uint32_t covered = 0;
+			for (auto j = i; covered < w; j++) {
+				y = std::max(y, skyline[j].y);
+				covered += skyline[j].width;
+			}
+			if (best == skyline.size() || y < best_y) {
+				best = i;
+				best_y = y;
+			}
+		}
+
+		auto x = skyline[best].x;
+		atlas.positions[idx] = { x, best_y };
+		atlas.height = std::max(atlas.height, best_y + h);
+
+		// the new segment replaces what it covers, a partly covered one keeps its right part.
+		auto end = best;
+		while (end < skyline.size() && skyline[end].x + skyline[end].width <= x + w) {
+			end++;
+		}
+		if (end < skyline.size() && skyline[end].x < x + w) {
+			skyline[end].width -= x + w - skyline[end].x;
+			skyline[end].x = x + w;
+		}
+		skyline.erase(skyline.begin() + best, skyline.begin() + end);
+		skyline.insert(skyline.begin() + best, { x, best_y + h, w });
+
+		// neighbours at the same height are one segment
+		for (std::size_t i = 0; i + 1 < skyline.size();) {
+			if (skyline[i].y == skyline[i + 1].y) {
+				skyline[i].width += skyline[i + 1].width;
+				skyline.erase(skyline.begin() + i + 1);
+			}
+			else {
+				i++;
+			}
+		}
+	}
+
+	for (auto [idx, first] : shared) {
+		atlas.positions[idx] = atlas.positions[first];
+	}
+
+	return atlas;
+}
+
+std::vector<uint8_t> SirPngWriter::Encode(const SirFont& sir, int data_idx, const Atlas& atlas, const PngWriteOptions& options)
+{
+	auto png_width = atlas.width;
+	auto png_height = std::max<uint32_t>(atlas.height, 1);
 
 	std::vector<png_byte> png_buffer;
 	png_buffer.resize(png_width * png_height, 0);
 
-	for (int i = 0; i < nsize; i++) {
+	for (std::size_t i = 0; i < sir.nodes.size(); i++) {
 		auto& n = sir.nodes[i];
-		auto iw = (i % wcount);
-		auto ih = (i / wcount);
-		for (int j = 0; j < n->data[data_idx].size(); j++) {
-			auto jw = (j % n->wsize[data_idx]);
-			auto jh = (j / n->wsize[data_idx]);
-			auto wtotal = (iw * data_width + jw);
-			auto htotal = (ih * data_height + jh) * png_width;
-			auto p = &png_buffer[(wtotal + htotal)];
-			*(p + 0) = n->data[data_idx][j];
+		auto [x, y] = atlas.positions[i];
+		auto src = sir.Pixels(*n, data_idx).data();
+		for (int row = 0; row < n->hsize[data_idx]; row++) {
+			memcpy(&png_buffer[(y + row) * png_width + x], src + row * n->wsize[data_idx], n->wsize[data_idx]);
 		}
 	}
 	std::vector<png_bytep> png_rows;
 	png_rows.resize(png_height);
-	for (int i = 0; i < png_height; i++) {
+	for (uint32_t i = 0; i < png_height; i++) {
 		png_rows[i] = &png_buffer[i * png_width];
 	}
 
-	FILE* fp;
-	fopen_s(&fp, file_path.string().c_str(), "wb");
+	std::vector<uint8_t> file;
 	auto png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
 	auto info_ptr = png_create_info_struct(png_ptr);
-	png_init_io(png_ptr, fp);
+	if (setjmp(png_jmpbuf(png_ptr))) {
+		png_destroy_write_struct(&png_ptr, &info_ptr);
+		throw std::runtime_error("png encoding failed");
+	}
+	png_set_write_fn(png_ptr, &file, [](png_structp png_ptr, png_bytep data, png_size_t size) {
+		auto file = (std::vector<uint8_t>*)png_get_io_ptr(png_ptr);
+		file->insert(file->end(), data, data + size);
+	}, nullptr);
+	if (options.compression_level >= 0) {
+		png_set_compression_level(png_ptr, options.compression_level);
+	}
+	if (options.strategy >= 0) {
+		png_set_compression_strategy(png_ptr, options.strategy);
+	}
+	if (options.filters != 0) {
+		png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, options.filters);
+	}
 	png_set_IHDR(png_ptr, info_ptr, png_width, png_height, 8, PNG_COLOR_TYPE_GRAY, PNG_INTERLACE_NONE,
 		PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
 	png_write_info(png_ptr, info_ptr);
 	png_write_image(png_ptr, png_rows.data());
 	png_write_end(png_ptr, nullptr);
-	fclose(fp);
-}
\ No newline at end of file
+	png_destroy_write_struct(&png_ptr, &info_ptr);
+
+	return file;
+}
+
+bool SirPngWriter::Write(const SirFont& sir, int data_idx, const Atlas& atlas, fs::path file_path)
+{
+	auto file = Encode(sir, data_idx, atlas, write_options);
+	return WriteFile(file_path, file.data(), file.size());
+}
@@ -2,7 +2,44 @@
 
 #include "Sir.hpp"
 
+// zlib and filter settings of the encoder, the default ones are what libpng picks by itself.
+struct PngWriteOptions
+{
+	int compression_level = -1; // 0 - 9, -1 for zlib's default
+	int filters = 0;            // PNG_FILTER_* flags, 0 for libpng's choice
+	int strategy = -1;          // zlib strategy, -1 for libpng's choice
+
+	// for iterating on a translation : a few times faster, somewhat bigger files
+	static PngWriteOptions Fast() { return { 1, PNG_FILTER_SUB, 3 /* Z_RLE */ }; }
+	// for a release : every filter tried on every row, smallest files
+	static PngWriteOptions Max() { return { 9, PNG_ALL_FILTERS, 0 /* Z_DEFAULT_STRATEGY */ }; }
+
+	// "default", "fast" or "max"
+	static bool FromName(std::string_view name, PngWriteOptions& options)
+	{
+		if (name == "default") options = PngWriteOptions();
+		else if (name == "fast") options = Fast();
+		else if (name == "max") options = Max();
+		else return false;
+		return true;
+	}
+};
+
 class SirPngWriter {
 public:
-	static void Write(const SirFont& sir, int data_idx, fs::path file_path);
+	// what Write encodes with, set once before any tool runs.
+	static inline PngWriteOptions write_options;
+
+	// where the glyphs of a plane go in its png, recorded in the .font.xml by SirXmlWriter.
+	struct Atlas
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<std::array<uint32_t, 2>> positions; // x, y of each node, in node order
+	};
+	static Atlas Layout(const SirFont& sir, int data_idx);
+
+	// the png file of a plane in memory, laid out by Layout(sir, data_idx).
+	static std::vector<uint8_t> Encode(const SirFont& sir, int data_idx, const Atlas& atlas, const PngWriteOptions& options);
+	static bool Write(const SirFont& sir, int data_idx, const Atlas& atlas, fs::path file_path);
 };
\ No newline at end of file
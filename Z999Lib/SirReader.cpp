@@ -1,5 +1,29 @@
 #include "SirReader.hpp"
 
+// the probes below read strings through these and never intern them, a file is only interned once it is read for real.
+static std::string_view ReadString(const std::span<char>& buffer, uint64_t offset)
+{
+	if (offset >= buffer.size()) {
+		throw std::runtime_error("invalid memory access");
+	}
+	auto beg = buffer.data() + offset;
+	auto end = (const char*)memchr(beg, 0, buffer.size() - offset);
+	if (end == nullptr) {
+		throw std::runtime_error("invalid memory access");
+	}
+	return std::string_view(beg, end - beg);
+}
+template<std::size_t N>
+static std::array<std::string_view, N> ReadStrings(const std::span<char>& buffer, uint64_t offset)
+{
+	std::array<std::string_view, N> str_array;
+	for (auto& str : str_array) {
+		str = ReadString(buffer, offset);
+		offset += str.length() + 1;
+	}
+	return str_array;
+}
+
 std::shared_ptr<SirDlg> SirReader::ReadDlg(std::string filename, const std::span<char>& buffer)
 {
 	const char* orig_pos = buffer.data();
@@ -12,7 +36,7 @@ std::shared_ptr<SirDlg> SirReader::ReadDlg(std::string filename, const std::span
 	auto content_size = (orig_pos + footer_beg) - content_pos;
 
 	if (buffer.size() < footer_end) {
-		throw std::exception("invalid memory access");
+		throw std::runtime_error("invalid memory access");
 	}
 	curr_pos = orig_pos + footer_beg;
 
@@ -37,32 +61,27 @@ std::shared_ptr<SirDlg> SirReader::ReadDlg(std::string filename, const std::span
 }
 std::shared_ptr<SirDlg::Node> SirReader::ReadDlgNode(const std::span<char>& buffer, uint64_t offset)
 {
-	const char* orig_pos = buffer.data();
-	auto curr_pos = orig_pos + offset;
 	auto n = std::make_shared<SirDlg::Node>();
 
-	std::array<std::string*, 4> str_array = { &n->id__, &n->type, &n->name, &n->text };
-	for (auto& str : str_array) {
-		if (buffer.size() < (curr_pos - orig_pos) + strlen(curr_pos) + 1) {
-			throw std::exception("invalid memory access");
-		}
-		*str = curr_pos; curr_pos += strlen(curr_pos) + 1;
-	}
+	auto str_array = ReadStrings<4>(buffer, offset);
+	n->id__ = str_array[0];
+	n->type = str_array[1];
+	n->name = str_array[2];
+	n->text = str_array[3];
 	return n;
 }
 bool SirReader::IsValidDlg(const std::span<char>& buffer)
 {
 	try {
-		uint64_t offset = 4 + 8 + 8;
-		auto n = ReadDlgNode(buffer, offset);
-		auto dlg_id_len = n->id__.length();
-		if (dlg_id_len < 15 || n->id__.find('_') == std::string::npos) {
+		auto str_array = ReadStrings<4>(buffer, 4 + 8 + 8);
+		auto id = str_array[0];
+		if (id.length() < 15 || id.find('_') == std::string_view::npos) {
 			return false;
 		}
-		if (!isdigit(n->id__.at(dlg_id_len - 2)) || !isdigit(n->id__.at(dlg_id_len - 1))) {
+		if (!isdigit(id[id.length() - 2]) || !isdigit(id[id.length() - 1])) {
 			return false;
 		}
-		if (n->type.length() == 0) {
+		if (str_array[1].empty()) {
 			return false;
 		}
 		return true;
@@ -84,7 +103,7 @@ std::shared_ptr<SirName> SirReader::ReadName(std::string filename, const std::sp
 	auto content_size = (orig_pos + footer_beg) - content_pos;
 
 	if (buffer.size() < footer_end) {
-		throw std::exception("invalid memory access");
+		throw std::runtime_error("invalid memory access");
 	}
 	curr_pos = orig_pos + footer_beg;
 
@@ -100,14 +119,14 @@ std::shared_ptr<SirName> SirReader::ReadName(std::string filename, const std::sp
 		}
 		else {
 			if (offset >= buffer.size()) {
-				throw std::exception("invalid memory access");
+				throw std::runtime_error("invalid memory access");
 			}
 			offsets.push_back(offset);
 		}
 	}
 
 	if (offsets.empty() || offsets.size() / 4 > node_types.size()) {
-		throw std::exception("invalid memory access");
+		throw std::runtime_error("invalid memory access");
 	}
 
 	auto sir = std::make_shared<SirName>();
@@ -124,28 +143,23 @@ std::shared_ptr<SirName> SirReader::ReadName(std::string filename, const std::sp
 }
 std::shared_ptr<SirName::Node> SirReader::ReadNameNode(const std::span<char>& buffer, uint64_t offset)
 {
-	const char* orig_pos = buffer.data();
-	auto curr_pos = orig_pos + offset;
 	auto n = std::make_shared<SirName::Node>();
 
-	std::array<std::string*, 4> str_array = { &n->key_name, &n->name, &n->key_msg, &n->msg };
-	for (auto& str : str_array) {
-		if (buffer.size() < (curr_pos - orig_pos) + strlen(curr_pos) + 1) {
-			throw std::exception("invalid memory access");
-		}
-		*str = curr_pos; curr_pos += strlen(curr_pos) + 1;
-	}
+	auto str_array = ReadStrings<4>(buffer, offset);
+	n->key_name = str_array[0];
+	n->name = str_array[1];
+	n->key_msg = str_array[2];
+	n->msg = str_array[3];
 	return n;
 }
 bool SirReader::IsValidName(const std::span<char>& buffer)
 {
 	try {
-		uint64_t offset = 4 + 8 + 8;
-		auto n = ReadNameNode(buffer, offset);
-		if (n->key_name != "&NONE") {
+		auto str_array = ReadStrings<4>(buffer, 4 + 8 + 8);
+		if (str_array[0] != "&NONE") {
 			return false;
 		}
-		if (n->key_msg.empty() || n->key_name.empty() || n->msg.empty() || n->name.empty()) {
+		if (str_array[1].empty() || str_array[2].empty() || str_array[3].empty()) {
 			return false;
 		}
 		return true;
@@ -167,7 +181,7 @@ std::shared_ptr<SirFont> SirReader::ReadFont(std::string filename, const std::sp
 	auto content_size = (orig_pos + footer_beg) - content_pos;
 
 	if (buffer.size() < footer_end) {
-		throw std::exception("invalid memory access");
+		throw std::runtime_error("invalid memory access");
 	}
 	
 	auto footer_count = *((uint64_t*)(orig_pos + footer_beg));
@@ -185,9 +199,14 @@ std::shared_ptr<SirFont> SirReader::ReadFont(std::string filename, const std::sp
 	sir->nodes.reserve(footer_font_values.size());
 	uint64_t offset = 4 + 8 + 8;
 	while (offset < footer_beg) {
-		sir->nodes.push_back(ReadFontNode(buffer, offset));
-		auto& back = sir->nodes.back();
-		offset += back->Size();
+		auto n = ReadFontNode(buffer, offset);
+		auto curr_pos = orig_pos + offset + 10;
+		for (int i = 0; i < 2; i++) {
+			auto dst = sir->AllocPixels(*n, i);
+			memcpy(dst.data(), curr_pos, dst.size()); curr_pos += dst.size();
+		}
+		sir->nodes.push_back(n);
+		offset += n->Size();
 	}
 
 	return sir;
@@ -198,7 +217,7 @@ std::shared_ptr<SirFont::Node> SirReader::ReadFontNode(const std::span<char>& bu
 	auto curr_pos = orig_pos + offset;
 	auto n = std::make_shared<SirFont::Node>();
 	if (buffer.size() < (curr_pos - orig_pos) + 10) {
-		throw std::exception("invalid memory access");
+		throw std::runtime_error("invalid memory access");
 	}
 	memcpy(n->keycode, curr_pos, 6); curr_pos += 6;
 	n->wsize[0] = *(uint8_t*)curr_pos; curr_pos += 1;
@@ -208,18 +227,16 @@ std::shared_ptr<SirFont::Node> SirReader::ReadFontNode(const std::span<char>& bu
 	auto f1_size = n->wsize[0] * n->hsize[0];
 	auto f2_size = n->wsize[1] * n->hsize[1];
 	if (f1_size <= 0 || f2_size <= 0) {
-		throw std::exception("invalid memory access");
+		throw std::runtime_error("invalid memory access");
 	}
 	if (buffer.size() < (curr_pos - orig_pos) + f1_size + f2_size) {
-		throw std::exception("invalid memory access");
+		throw std::runtime_error("invalid memory access");
 	}
-	n->data[0].resize(f1_size);
-	n->data[1].resize(f2_size);
-	memcpy(&n->data[0][0], curr_pos, f1_size); curr_pos += f1_size;
-	memcpy(&n->data[1][0], curr_pos, f2_size); curr_pos += f2_size;
+	// the pixels are left to the font, they go to its arenas.
+	curr_pos += f1_size + f2_size;
 	auto padding = n->Padding();
 	if (buffer.size() < (curr_pos - orig_pos) + padding) {
-		throw std::exception("invalid memory access");
+		throw std::runtime_error("invalid memory access");
 	}
 	curr_pos += n->Padding();
 	return n;
@@ -256,7 +273,7 @@ std::shared_ptr<SirItem> SirReader::ReadItem(std::string filename, const std::sp
 	auto content_size = (orig_pos + footer_beg) - content_pos;
 
 	if (buffer.size() < footer_end) {
-		throw std::exception("invalid memory access");
+		throw std::runtime_error("invalid memory access");
 	}
 	curr_pos = orig_pos + footer_beg;
 
@@ -301,7 +318,7 @@ std::shared_ptr<SirItem::Node> SirReader::ReadItemNode(const std::span<char>& bu
 		auto offset_text1 = reader.Read<uint64_t>();
 		auto offset_text2 = reader.Read<uint64_t>();
 		if (offset_key >= buffer.size() || offset_text1 >= buffer.size() || offset_text2 >= buffer.size()) {
-			throw std::exception("invalid memory access");
+			throw std::runtime_error("invalid memory access");
 		}
 
 		auto item = std::make_shared<SirItem::Node::Item>();
@@ -317,12 +334,20 @@ std::shared_ptr<SirItem::Node> SirReader::ReadItemNode(const std::span<char>& bu
 bool SirReader::IsValidItem(const std::span<char>& buffer)
 {
 	try {
-		auto n = ReadItemNode(buffer, *(uint64_t*)(&buffer.front() + 4));
-		if (n->items.empty()) {
+		MemReader reader(buffer);
+		reader.Seek(4);
+		reader.Seek(reader.Read<uint64_t>());
+		auto data_offset = reader.Read<uint64_t>();
+		auto info_offset = reader.Read<uint64_t>();
+		ReadString(buffer, data_offset);
+
+		reader.Seek(info_offset);
+		auto offset_key = reader.Read<uint64_t>();
+		if (offset_key == 0) {
 			return false;
 		}
-		auto& front = n->items.front();
-		if (front->key.empty() || front->key.front() != '^') {
+		auto key = ReadString(buffer, offset_key);
+		if (key.empty() || key.front() != '^') {
 			return false;
 		}
 		return true;
@@ -344,7 +369,7 @@ std::shared_ptr<SirMsg> SirReader::ReadMsg(std::string filename, const std::span
 	auto content_size = (orig_pos + footer_beg) - content_pos;
 
 	if (buffer.size() < footer_end) {
-		throw std::exception("invalid memory access");
+		throw std::runtime_error("invalid memory access");
 	}
 	curr_pos = orig_pos + footer_beg;
 
@@ -358,7 +383,7 @@ std::shared_ptr<SirMsg> SirReader::ReadMsg(std::string filename, const std::span
 	}
 
 	if (offsets.empty() || offsets.front() + 24 >= buffer.size()) {
-		throw std::exception("invalid file");
+		throw std::runtime_error("invalid file");
 	}
 
 	auto data_max_pos = orig_pos + *((uint64_t*)(orig_pos + (offsets.front() + 24))) - 1;
@@ -408,8 +433,10 @@ std::shared_ptr<SirMsg::Node> SirReader::ReadMsgNode(const std::span<char>& buff
 bool SirReader::IsValidMsg(const std::span<char>& buffer)
 {
 	try {
-		auto n = ReadMsgNode(buffer, *(uint64_t*)(&buffer.front() + 4), 0);
-		if (n->key != "START_CREATE_FIRST") {
+		MemReader reader(buffer);
+		reader.Seek(4);
+		reader.Seek(reader.Read<uint64_t>());
+		if (ReadString(buffer, reader.Read<uint64_t>()) != "START_CREATE_FIRST") {
 			return false;
 		}
 		return true;
@@ -440,11 +467,11 @@ std::shared_ptr<SirDesc> SirReader::ReadDesc(std::string filename, const std::sp
 	auto var_offset = reader.Read<uint64_t>();
 
 	if (buffer.size() < sound_file_name_offset || buffer.size() < node_info_offset) {
-		throw std::exception("invalid memory access");
+		throw std::runtime_error("invalid memory access");
 	}
 
 	if (buffer.size() < text_offset || buffer.size() < start_offset || buffer.size() < var_offset) {
-		throw std::exception("invalid memory access");
+		throw std::runtime_error("invalid memory access");
 	}
 
 	auto sir = std::make_shared<SirDesc>();
@@ -502,7 +529,7 @@ std::shared_ptr<SirDesc> SirReader::ReadDesc(std::string filename, const std::sp
 	}
 
 	if (sir->nodes.empty() || sir->texts.empty()) {
-		throw std::exception("invalid file");
+		throw std::runtime_error("invalid file");
 	}
 
 	auto& last_node = sir->nodes.back();
@@ -521,7 +548,7 @@ std::shared_ptr<SirDesc::Node> SirReader::ReadDescNode(const std::span<char>& bu
 	const char* orig_pos = buffer.data();
 
 	if (buffer.size() < offset || buffer.size() < text_offset) {
-		throw std::exception("invalid memory access");
+		throw std::runtime_error("invalid memory access");
 	}
 
 	auto n = std::make_shared<SirDesc::Node>();
@@ -530,7 +557,7 @@ std::shared_ptr<SirDesc::Node> SirReader::ReadDescNode(const std::span<char>& bu
 	MemReader reader(buffer);
 	reader.Seek(offset);
 	if (reader.Read<uint8_t>() != 0x25) {
-		throw std::exception("invalid memory access");
+		throw std::runtime_error("invalid memory access");
 	}
 
 	if (next_offset > offset) {
@@ -573,10 +600,10 @@ bool SirReader::IsValidDesc(const std::span<char>& buffer)
 		if (next_offset <= data_offset) {
 			return false;
 		}
-		auto n = ReadDescNode(buffer, data_offset, next_offset, name_offset);
-		/*if (n->key != "START_CREATE_FIRST") {
+		if (next_offset > buffer.size() || buffer[data_offset] != 0x25) {
 			return false;
-		}*/
+		}
+		ReadString(buffer, name_offset);
 		return true;
 	}
 	catch (const std::exception& e) {
@@ -595,7 +622,7 @@ std::shared_ptr<SirFChart> SirReader::ReadFChart(std::string filename, const std
 	auto footer_end = reader.Read<uint64_t>();
 
 	if (footer_beg >= footer_end || buffer.size() < footer_end) {
-		throw std::exception("invalid memory access");
+		throw std::runtime_error("invalid memory access");
 	}
 
 	reader.Seek(footer_beg);
@@ -619,7 +646,7 @@ std::shared_ptr<SirFChart> SirReader::ReadFChart(std::string filename, const std
 	}
 
 	if (sir->nodes.empty()) {
-		throw std::exception("invalid file");
+		throw std::runtime_error("invalid file");
 	}
 
 	return sir;
@@ -629,7 +656,7 @@ std::shared_ptr<SirFChart::Node> SirReader::ReadFChartNode(const std::span<char>
 	auto size = buffer.size();
 
 	if (size < offset) {
-		throw std::exception("invalid memory access");
+		throw std::runtime_error("invalid memory access");
 	}
 
 	MemReader reader(buffer);
@@ -641,7 +668,7 @@ std::shared_ptr<SirFChart::Node> SirReader::ReadFChartNode(const std::span<char>
 		reader.Read(n_offsets[i]);
 		if (i > 0 && n_offsets[i] <= n_offsets[i - 1])
 		{
-			throw std::exception("invalid memory access");
+			throw std::runtime_error("invalid memory access");
 		}
 	}
 
@@ -672,7 +699,7 @@ std::shared_ptr<SirFChart::Node> SirReader::ReadFChartNode(const std::span<char>
 			reader.Read(i_offsets[i + 1]);
 			if (i > 0 && i_offsets[i] <= i_offsets[i - 1])
 			{
-				throw std::exception("invalid memory access");
+				throw std::runtime_error("invalid memory access");
 			}
 		}
 
@@ -700,10 +727,16 @@ bool SirReader::IsValidFChart(const std::span<char>& buffer)
 
 		reader.Forward(4);
 		auto footer_beg = reader.Read<uint64_t>();
-		auto footer_end = reader.Read<uint64_t>();
 
-		auto n = ReadFChartNode(buffer, footer_beg);
-		if (n->id1 != "A01b_novel_1")
+		reader.Seek(footer_beg);
+		std::array<uint64_t, 11> n_offsets;
+		for (int i = 0; i < 11; i++) {
+			reader.Read(n_offsets[i]);
+			if (i > 0 && n_offsets[i] <= n_offsets[i - 1]) {
+				return false;
+			}
+		}
+		if (ReadString(buffer, n_offsets[0]) != "A01b_novel_1")
 			return false;
 
 		return true;
@@ -725,7 +758,7 @@ std::shared_ptr<SirDoc> SirReader::ReadDoc(std::string filename, const std::span
 	auto content_size = (orig_pos + footer_beg) - content_pos;
 
 	if (buffer.size() < footer_end) {
-		throw std::exception("invalid memory access");
+		throw std::runtime_error("invalid memory access");
 	}
 	curr_pos = orig_pos + footer_beg;
 
@@ -739,7 +772,7 @@ std::shared_ptr<SirDoc> SirReader::ReadDoc(std::string filename, const std::span
 	}
 
 	if (offsets.empty() || offsets.front() + 24 >= buffer.size()) {
-		throw std::exception("invalid file");
+		throw std::runtime_error("invalid file");
 	}
 
 	auto data_max_pos = orig_pos + *((uint64_t*)(orig_pos + (offsets.front() + 24))) - 1;
@@ -800,8 +833,10 @@ std::shared_ptr<SirDoc::Node> SirReader::ReadDocNode(const std::span<char>& buff
 bool SirReader::IsValidDoc(const std::span<char>& buffer)
 {
 	try {
-		auto n = ReadDocNode(buffer, *(uint64_t*)(&buffer.front() + 4), 0);
-		if (n->key1 != "$FILE_ESC_A01_0") {
+		MemReader reader(buffer);
+		reader.Seek(4);
+		reader.Seek(reader.Read<uint64_t>());
+		if (ReadString(buffer, reader.Read<uint64_t>()) != "$FILE_ESC_A01_0") {
 			return false;
 		}
 		return true;
@@ -823,7 +858,7 @@ std::shared_ptr<SirMap> SirReader::ReadMap(std::string filename, const std::span
 	auto content_size = (orig_pos + footer_beg) - content_pos;
 
 	if (buffer.size() < footer_end) {
-		throw std::exception("invalid memory access");
+		throw std::runtime_error("invalid memory access");
 	}
 	curr_pos = orig_pos + footer_beg;
 
@@ -898,8 +933,14 @@ bool SirReader::IsValidMap(const std::span<char>& buffer)
 		MemReader reader(buffer);
 		reader.Forward(4);
 
-		auto n = ReadMapNode(buffer, reader.Read<uint64_t>());
-		if (n->name != "A01" || n->items.empty()) {
+		reader.Seek(reader.Read<uint64_t>());
+		auto node_name_offset = reader.Read<uint64_t>();
+		auto items_offset = reader.Read<uint64_t>();
+		if (ReadString(buffer, node_name_offset) != "A01") {
+			return false;
+		}
+		reader.Seek(items_offset);
+		if (reader.Read<uint64_t>() == 0) {
 			return false;
 		}
 		return true;
@@ -921,7 +962,7 @@ std::shared_ptr<SirCredit> SirReader::ReadCredit(std::string filename, const std
 	auto content_size = (orig_pos + footer_beg) - content_pos;
 
 	if (buffer.size() < footer_end) {
-		throw std::exception("invalid memory access");
+		throw std::runtime_error("invalid memory access");
 	}
 	curr_pos = orig_pos + footer_beg;
 
@@ -984,8 +1025,14 @@ bool SirReader::IsValidCredit(const std::span<char>& buffer)
 		MemReader reader(buffer);
 		reader.Forward(4);
 
-		auto n = ReadCreditNode(buffer, reader.Read<uint64_t>());
-		if (n->name != "AEnding" || n->items.empty()) {
+		reader.Seek(reader.Read<uint64_t>());
+		auto node_name_offset = reader.Read<uint64_t>();
+		auto items_offset = reader.Read<uint64_t>();
+		if (ReadString(buffer, node_name_offset) != "AEnding") {
+			return false;
+		}
+		reader.Seek(items_offset);
+		if (reader.Read<uint64_t>() == 0) {
 			return false;
 		}
 		return true;
@@ -1007,7 +1054,7 @@ std::shared_ptr<SirRoom> SirReader::ReadRoom(std::string filename, const std::sp
 	auto content_size = (orig_pos + footer_beg) - content_pos;
 
 	if (buffer.size() < footer_end) {
-		throw std::exception("invalid memory access");
+		throw std::runtime_error("invalid memory access");
 	}
 	curr_pos = orig_pos + footer_beg;
 
@@ -1082,8 +1129,20 @@ bool SirReader::IsValidRoom(const std::span<char>& buffer)
 		MemReader reader(buffer);
 		reader.Forward(4);
 
-		auto n = ReadRoomNode(buffer, reader.Read<uint64_t>());
-		if (n->name != "A ROOT" || n->items.empty() || n->items.front()->key.empty() || n->items.front()->key[0] != '$') {
+		reader.Seek(reader.Read<uint64_t>());
+		auto node_name_offset = reader.Read<uint64_t>();
+		auto items_offset = reader.Read<uint64_t>();
+		if (ReadString(buffer, node_name_offset) != "A ROOT") {
+			return false;
+		}
+		reader.Seek(items_offset);
+		std::array<uint64_t, 5> item_offsets;
+		reader.ReadArray(item_offsets);
+		if (item_offsets[0] == 0) {
+			return false;
+		}
+		auto key = ReadString(buffer, item_offsets[2]);
+		if (key.empty() || key[0] != '$') {
 			return false;
 		}
 		return true;
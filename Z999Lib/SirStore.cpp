@@ -0,0 +1,236 @@
+#include "SirStore.hpp"
+#include "XmlEmitter.hpp"
+
+bool SirStore::Open(const fs::path& file_path)
+{
+	Close();
+	if (!mapped.Open(file_path) || mapped.Size() < sizeof(Header)) {
+		Close();
+		return false;
+	}
+
+	auto data = mapped.Data();
+	auto size = (uint64_t)mapped.Size();
+	Header header;
+	memcpy(&header, data, sizeof(Header));
+	if (memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version) {
+		Close();
+		return false;
+	}
+
+	uint64_t pos = sizeof(Header);
+	auto func_table = [&](auto& table, uint32_t count) {
+		using T = typename std::remove_reference_t<decltype(table)>::element_type;
+		if (pos + (uint64_t)count * sizeof(T) > size) {
+			return false;
+		}
+		table = std::span<const T>((const T*)(data + pos), count);
+		pos += (uint64_t)count * sizeof(T);
+		return true;
+	};
+	if (!func_table(files, header.file_count) || !func_table(elements, header.element_count) ||
+		!func_table(attributes, header.attribute_count) || !func_table(strings, header.string_count) ||
+		pos + header.string_data_size > size) {
+		Close();
+		return false;
+	}
+	string_data = data + pos;
+
+	// every index is checked once here, the views don't check again.
+	for (auto& s : strings) {
+		if ((uint64_t)s.offset + s.size >= header.string_data_size || string_data[s.offset + s.size] != 0) {
+			Close();
+			return false;
+		}
+	}
+	auto string_count = (uint32_t)strings.size();
+	for (auto& a : attributes) {
+		if (a.name >= string_count || a.value >= string_count) {
+			Close();
+			return false;
+		}
+	}
+	// elements are in document order, so a link only points forward. that keeps the walks from looping.
+	for (std::size_t i = 0; i < elements.size(); i++) {
+		auto& e = elements[i];
+		if (e.name >= string_count || (uint64_t)e.attribute_begin + e.attribute_count > attributes.size() ||
+			(e.first_child != None && e.first_child <= i) || (e.next_sibling != None && e.next_sibling <= i)) {
+			Close();
+			return false;
+		}
+	}
+	for (std::size_t i = 0; i < files.size(); i++) {
+		auto& f = files[i];
+		if (f.name >= string_count || (uint64_t)f.element_begin + f.element_count > elements.size()) {
+			Close();
+			return false;
+		}
+		// the links of a file stay inside its elements.
+		auto element_end = f.element_begin + f.element_count;
+		for (auto k = f.element_begin; k < element_end; k++) {
+			auto& e = elements[k];
+			if ((e.first_child != None && e.first_child >= element_end) || (e.next_sibling != None && e.next_sibling >= element_end)) {
+				Close();
+				return false;
+			}
+		}
+		if (i > 0 && String(files[i - 1].name) >= String(f.name)) {
+			Close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void SirStore::Close()
+{
+	files = {};
+	elements = {};
+	attributes = {};
+	strings = {};
+	string_data = nullptr;
+	mapped.Close();
+}
+
+std::optional<SirStore::FileRef> SirStore::Find(std::string_view name) const
+{
+	auto it = std::lower_bound(files.begin(), files.end(), name, [&](const FileRecord& f, std::string_view n) {
+		return String(f.name) < n;
+	});
+	if (it == files.end() || String(it->name) != name) {
+		return std::nullopt;
+	}
+	return FileRef(this, (uint32_t)(it - files.begin()));
+}
+
+uint64_t SirStore::FileRef::Hash(uint64_t seed) const
+{
+	auto& f = Record();
+	for (auto i = f.element_begin; i < f.element_begin + f.element_count; i++) {
+		auto& e = store->elements[i];
+		seed = HashString(store->String(e.name), seed);
+		seed = HashBytes(&e.attribute_count, sizeof(e.attribute_count), seed);
+		for (auto a = e.attribute_begin; a < e.attribute_begin + e.attribute_count; a++) {
+			seed = HashString(store->String(store->attributes[a].name), seed);
+			seed = HashString(store->String(store->attributes[a].value), seed);
+		}
+		// the tree shape as offsets inside the file, so moving the file in the store doesn't change it.
+		auto first_child = e.first_child == None ? None : e.first_child - f.element_begin;
+		auto next_sibling = e.next_sibling == None ? None : e.next_sibling - f.element_begin;
+		seed = HashBytes(&first_child, sizeof(first_child), seed);
+		seed = HashBytes(&next_sibling, sizeof(next_sibling), seed);
+	}
+	return seed;
+}
+
+bool SirStore::Pack(const fs::path& base_dir_path, const std::vector<fs::path>& xml_paths, const fs::path& store_path)
+{
+	std::vector<FileRecord> files;
+	std::vector<ElementRecord> elements;
+	std::vector<AttributeRecord> attributes;
+	std::vector<StringRecord> strings;
+	std::string string_data;
+	std::unordered_map<std::string, uint32_t> string_ids;
+
+	auto func_string = [&](std::string_view s) {
+		auto [it, inserted] = string_ids.try_emplace(std::string(s), (uint32_t)strings.size());
+		if (inserted) {
+			strings.push_back({ (uint32_t)string_data.size(), (uint32_t)s.size() });
+			string_data += s;
+			string_data += '\0';
+		}
+		return it->second;
+	};
+
+	// elements are numbered in document order, a parent before its children.
+	std::string scratch;
+	auto func_element = [&](rapidxml::xml_node<char>* node, auto& func_element) -> uint32_t {
+		auto idx = (uint32_t)elements.size();
+		elements.push_back({ func_string(XmlName(node)), (uint32_t)attributes.size(), 0, None, None });
+		for (auto attr = node->first_attribute(); attr != nullptr; attr = attr->next_attribute()) {
+			attributes.push_back({ func_string(XmlName(attr)), func_string(XmlValue(attr, scratch)) });
+			elements[idx].attribute_count++;
+		}
+		auto prev = None;
+		for (auto child = node->first_node(); child != nullptr; child = child->next_sibling()) {
+			if (child->type() != rapidxml::node_element) {
+				continue;
+			}
+			auto child_idx = func_element(child, func_element);
+			if (prev == None) {
+				elements[idx].first_child = child_idx;
+			}
+			else {
+				elements[prev].next_sibling = child_idx;
+			}
+			prev = child_idx;
+		}
+		return idx;
+	};
+
+	std::vector<std::pair<std::string, fs::path>> sorted_paths;
+	for (auto& p : xml_paths) {
+		sorted_paths.emplace_back(fs::relative(p, base_dir_path).generic_string(), p);
+	}
+	std::sort(sorted_paths.begin(), sorted_paths.end());
+
+	for (auto& [name, path] : sorted_paths) {
+		XmlFile doc(path);
+		auto element_begin = (uint32_t)elements.size();
+		for (auto node = doc.first_node(); node != nullptr; node = node->next_sibling()) {
+			if (node->type() == rapidxml::node_element) {
+				func_element(node, func_element);
+				break;
+			}
+		}
+		files.push_back({ func_string(name), element_begin, (uint32_t)elements.size() - element_begin });
+	}
+
+	Header header;
+	memcpy(header.magic, Magic, sizeof(Magic));
+	header.version = Version;
+	header.file_count = (uint32_t)files.size();
+	header.element_count = (uint32_t)elements.size();
+	header.attribute_count = (uint32_t)attributes.size();
+	header.string_count = (uint32_t)strings.size();
+	header.string_data_size = string_data.size();
+
+	std::ofstream ofs(store_path, std::ios::binary);
+	ofs.write((const char*)&header, sizeof(header));
+	ofs.write((const char*)files.data(), files.size() * sizeof(FileRecord));
+	ofs.write((const char*)elements.data(), elements.size() * sizeof(ElementRecord));
+	ofs.write((const char*)attributes.data(), attributes.size() * sizeof(AttributeRecord));
+	ofs.write((const char*)strings.data(), strings.size() * sizeof(StringRecord));
+	ofs.write(string_data.data(), string_data.size());
+	return !ofs.bad();
+}
+
+bool SirStore::Unpack(const fs::path& dst_dir_path) const
+{
+	XmlEmitter xml;
+	for (std::size_t i = 0; i < files.size(); i++) {
+		auto file = File(i);
+		auto file_path = fs::path(dst_dir_path).append(file.Name());
+		fs::create_directories(file_path.parent_path());
+
+		xml.Clear();
+		auto func_element = [&](NodeRef node, auto& func_element) -> void {
+			xml.Open(std::string_view(node->name(), node->name_size()));
+			for (auto attr = node->first_attribute(); attr != nullptr; attr = attr->next_attribute()) {
+				xml.Attribute(XmlName(attr), std::string_view(attr->value(), attr->value_size()));
+			}
+			for (auto child = node->first_node(); child != nullptr; child = child->next_sibling()) {
+				func_element(child, func_element);
+			}
+			xml.Close();
+		};
+		if (file.Root() != nullptr) {
+			func_element(file.Root(), func_element);
+		}
+		if (!xml.WriteFile(file_path)) {
+			return false;
+		}
+	}
+	return true;
+}
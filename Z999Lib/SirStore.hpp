@@ -0,0 +1,172 @@
+#pragma once
+
+#include "Common.hpp"
+
+// all patch xml files of a translation in one file that is read straight from its mapping.
+// every element and attribute of the xml is kept (entities already translated), so the xml files can be written back as they were.
+//
+// layout (little endian) :
+//   Header
+//   FileRecord[file_count]            sorted by name, looked up with a binary search
+//   ElementRecord[element_count]      the elements of a file are contiguous, its root first
+//   AttributeRecord[attribute_count]  the attributes of an element are contiguous, in document order
+//   StringRecord[string_count]
+//   string data                       every string is stored once and ends with a nul
+class SirStore
+{
+public:
+	static constexpr char Extension[] = ".sirstore";
+	static constexpr char Magic[4] = { 'S', 'I', 'R', 'S' };
+	static constexpr uint32_t Version = 1;
+	static constexpr uint32_t None = 0xFFFFFFFF;
+
+	struct Header
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t file_count;
+		uint32_t element_count;
+		uint32_t attribute_count;
+		uint32_t string_count;
+		uint64_t string_data_size;
+	};
+	struct FileRecord
+	{
+		uint32_t name; // path relative to the packed directory, '/' separated
+		uint32_t element_begin;
+		uint32_t element_count;
+	};
+	struct ElementRecord
+	{
+		uint32_t name;
+		uint32_t attribute_begin;
+		uint32_t attribute_count;
+		uint32_t first_child;
+		uint32_t next_sibling;
+	};
+	struct AttributeRecord
+	{
+		uint32_t name;
+		uint32_t value;
+	};
+	struct StringRecord
+	{
+		uint32_t offset;
+		uint32_t size;
+	};
+
+	// the views below walk like rapidxml nodes (node->first_node(), while (node != nullptr) ...), so one reader serves both.
+	class AttributeRef
+	{
+	public:
+		AttributeRef() = default;
+		AttributeRef(std::nullptr_t) {}
+		AttributeRef(const SirStore* _store, uint32_t _idx, uint32_t _end) : store(_store), idx(_idx), end(_end) {}
+
+		const AttributeRef* operator->() const { return this; }
+		bool operator==(std::nullptr_t) const { return store == nullptr; }
+
+		const char* name() const { return store->String(store->attributes[idx].name).data(); }
+		std::size_t name_size() const { return store->String(store->attributes[idx].name).size(); }
+		const char* value() const { return store->String(store->attributes[idx].value).data(); }
+		std::size_t value_size() const { return store->String(store->attributes[idx].value).size(); }
+
+		AttributeRef next_attribute() const
+		{
+			return idx + 1 < end ? AttributeRef(store, idx + 1, end) : AttributeRef();
+		}
+
+	private:
+		const SirStore* store = nullptr;
+		uint32_t idx = 0;
+		uint32_t end = 0;
+	};
+
+	class NodeRef
+	{
+	public:
+		NodeRef() = default;
+		NodeRef(std::nullptr_t) {}
+		NodeRef(const SirStore* _store, uint32_t _idx) : store(_idx == None ? nullptr : _store), idx(_idx) {}
+
+		const NodeRef* operator->() const { return this; }
+		bool operator==(std::nullptr_t) const { return store == nullptr; }
+
+		const char* name() const { return store->String(Record().name).data(); }
+		std::size_t name_size() const { return store->String(Record().name).size(); }
+
+		NodeRef first_node() const { return NodeRef(store, Record().first_child); }
+		NodeRef next_sibling() const { return NodeRef(store, Record().next_sibling); }
+		AttributeRef first_attribute() const
+		{
+			auto& r = Record();
+			return r.attribute_count > 0 ? AttributeRef(store, r.attribute_begin, r.attribute_begin + r.attribute_count) : AttributeRef();
+		}
+
+	private:
+		const ElementRecord& Record() const { return store->elements[idx]; }
+
+		const SirStore* store = nullptr;
+		uint32_t idx = 0;
+	};
+
+	class FileRef
+	{
+	public:
+		FileRef(const SirStore* _store, uint32_t _idx) : store(_store), idx(_idx) {}
+
+		std::string_view Name() const { return store->String(Record().name); }
+		// file name without directories and extensions, like fs::path::stem applied twice to a.dlg.xml
+		std::string Stem() const { return fs::path(Name()).stem().stem().string(); }
+		NodeRef Root() const { return Record().element_count > 0 ? NodeRef(store, Record().element_begin) : NodeRef(); }
+
+		// hash of the names and values of the file, independent of where its strings sit in the store.
+		uint64_t Hash(uint64_t seed = 0xCBF29CE484222325ULL) const;
+
+	private:
+		const FileRecord& Record() const { return store->files[idx]; }
+
+		const SirStore* store = nullptr;
+		uint32_t idx = 0;
+	};
+
+	static bool IsStorePath(const fs::path& path)
+	{
+		return path.extension() == Extension && fs::is_regular_file(path);
+	}
+
+	// false when the file is missing or broken, the store is empty then.
+	bool Open(const fs::path& file_path);
+	void Close();
+
+	std::size_t FileCount() const { return files.size(); }
+	FileRef File(std::size_t i) const { return FileRef(this, (uint32_t)i); }
+	std::optional<FileRef> Find(std::string_view name) const;
+
+	// xml_paths are stored under their path relative to base_dir_path.
+	static bool Pack(const fs::path& base_dir_path, const std::vector<fs::path>& xml_paths, const fs::path& store_path);
+	bool Unpack(const fs::path& dst_dir_path) const;
+
+private:
+	std::string_view String(uint32_t id) const
+	{
+		auto& s = strings[id];
+		return std::string_view(string_data + s.offset, s.size);
+	}
+
+	MappedFile mapped;
+	std::span<const FileRecord> files;
+	std::span<const ElementRecord> elements;
+	std::span<const AttributeRecord> attributes;
+	std::span<const StringRecord> strings;
+	const char* string_data = nullptr;
+};
+
+inline std::string_view XmlName(const SirStore::AttributeRef& attr)
+{
+	return std::string_view(attr.name(), attr.name_size());
+}
+inline std::string_view XmlValue(const SirStore::AttributeRef& attr, std::string&)
+{
+	return std::string_view(attr.value(), attr.value_size());
+}
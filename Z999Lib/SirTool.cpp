@@ -5,6 +5,8 @@
 #include "SirWriter.hpp"
 #include "SirXmlWriter.hpp"
 #include "SirPngWriter.hpp"
+#include "AhoCorasick.hpp"
+#include "PeFile.hpp"
 
 bool SirTool::Unpack(const fs::path& src_path, const fs::path& dst_dir_path)
 {
@@ -25,19 +27,23 @@ bool SirTool::Unpack(const fs::path& src_path, const fs::path& dst_dir_path)
 		fs::create_directory(dst_dir_path);
 	}
 
-	SirXmlWriter::WriteAll(org_set.dlgs, dst_dir_path);
-	SirXmlWriter::WriteAll(org_set.names, dst_dir_path);
-	SirXmlWriter::WriteAll(org_set.fonts, dst_dir_path);
-	SirXmlWriter::WriteAll(org_set.items, dst_dir_path);
-	SirXmlWriter::WriteAll(org_set.msgs, dst_dir_path);
-	SirXmlWriter::WriteAll(org_set.descs, dst_dir_path);
-	SirXmlWriter::WriteAll(org_set.fcharts, dst_dir_path);
-	SirXmlWriter::WriteAll(org_set.docs, dst_dir_path);
-	SirXmlWriter::WriteAll(org_set.maps, dst_dir_path);
-	SirXmlWriter::WriteAll(org_set.credits, dst_dir_path);
-	SirXmlWriter::WriteAll(org_set.rooms, dst_dir_path);
-
-	return true;
+	// every file of every kind goes to the pool at once.
+	ThreadPool::Tasks tasks;
+	std::atomic_bool written = true;
+	SirXmlWriter::AddWrites(org_set.dlgs, dst_dir_path, tasks, written);
+	SirXmlWriter::AddWrites(org_set.names, dst_dir_path, tasks, written);
+	SirXmlWriter::AddWrites(org_set.fonts, dst_dir_path, tasks, written);
+	SirXmlWriter::AddWrites(org_set.items, dst_dir_path, tasks, written);
+	SirXmlWriter::AddWrites(org_set.msgs, dst_dir_path, tasks, written);
+	SirXmlWriter::AddWrites(org_set.descs, dst_dir_path, tasks, written);
+	SirXmlWriter::AddWrites(org_set.fcharts, dst_dir_path, tasks, written);
+	SirXmlWriter::AddWrites(org_set.docs, dst_dir_path, tasks, written);
+	SirXmlWriter::AddWrites(org_set.maps, dst_dir_path, tasks, written);
+	SirXmlWriter::AddWrites(org_set.credits, dst_dir_path, tasks, written);
+	SirXmlWriter::AddWrites(org_set.rooms, dst_dir_path, tasks, written);
+	ThreadPool::Shared().RunAll(tasks);
+
+	return written;
 }
 
 bool SirTool::Repack(const fs::path& src_path, const fs::path& dst_dir_path)
@@ -52,30 +58,35 @@ bool SirTool::Repack(const fs::path& src_path, const fs::path& dst_dir_path)
 		}
 	}
 	else {
+		std::vector<fs::path> xml_paths;
 		for (auto i : fs::recursive_directory_iterator{ src_path }) {
 			if (i.is_regular_file() && i.path().extension() == ".xml") {
-				ReadXml(i.path(), org_set);
+				xml_paths.push_back(i.path());
 			}
 		}
+		ReadXmls(xml_paths, org_set);
 	}
 
 	if (!fs::exists(dst_dir_path)) {
 		fs::create_directory(dst_dir_path);
 	}
 
-	SirWriter::WriteAll(org_set.dlgs, dst_dir_path);
-	SirWriter::WriteAll(org_set.names, dst_dir_path);
-	SirWriter::WriteAll(org_set.fonts, dst_dir_path);
-	SirWriter::WriteAll(org_set.items, dst_dir_path);
-	SirWriter::WriteAll(org_set.msgs, dst_dir_path);
-	SirWriter::WriteAll(org_set.descs, dst_dir_path);
-	SirWriter::WriteAll(org_set.fcharts, dst_dir_path);
-	SirWriter::WriteAll(org_set.docs, dst_dir_path);
-	SirWriter::WriteAll(org_set.maps, dst_dir_path);
-	SirWriter::WriteAll(org_set.credits, dst_dir_path);
-	SirWriter::WriteAll(org_set.rooms, dst_dir_path);
-
-	return true;
+	ThreadPool::Tasks tasks;
+	std::atomic_bool written = true;
+	SirWriter::AddWrites(org_set.dlgs, dst_dir_path, tasks, written);
+	SirWriter::AddWrites(org_set.names, dst_dir_path, tasks, written);
+	SirWriter::AddWrites(org_set.fonts, dst_dir_path, tasks, written);
+	SirWriter::AddWrites(org_set.items, dst_dir_path, tasks, written);
+	SirWriter::AddWrites(org_set.msgs, dst_dir_path, tasks, written);
+	SirWriter::AddWrites(org_set.descs, dst_dir_path, tasks, written);
+	SirWriter::AddWrites(org_set.fcharts, dst_dir_path, tasks, written);
+	SirWriter::AddWrites(org_set.docs, dst_dir_path, tasks, written);
+	SirWriter::AddWrites(org_set.maps, dst_dir_path, tasks, written);
+	SirWriter::AddWrites(org_set.credits, dst_dir_path, tasks, written);
+	SirWriter::AddWrites(org_set.rooms, dst_dir_path, tasks, written);
+	ThreadPool::Shared().RunAll(tasks);
+
+	return written;
 }
 
 bool SirTool::CopyValid(const fs::path& org_dir_path, const fs::path& dst_dir_path)
@@ -114,39 +125,28 @@ bool SirTool::GeneratePatchFontChars(const fs::path& org_dir_path, const fs::pat
 
 	ReadSirDir(org_dir_path);
 
-	for (auto i : fs::recursive_directory_iterator{ patch_dir_path }) {
-		auto ip = i.path();
-		if (i.is_regular_file() && ip.extension() == ".xml") {
-			if (!StrCmpEndWith(ip.string(), SirFont::XmlExtension)) {
-				ReadXml(ip, patch_set);
-			}
-		}
+	if (!ReadPatchTexts(patch_dir_path, patch_set)) {
+		return false;
 	}
 
 	std::wstring kormap_string;
 	{
-		std::set<wchar_t> w_keycodes;
+		CharSet w_keycodes;
 		RetrievePatchChars(scope_min, scope_max, w_keycodes);
-		RetrieveExPatchChars(patch_dir_path, scope_min, scope_max, w_keycodes);
-		kormap_string.reserve(w_keycodes.size() + 10);
-		for (auto& w : w_keycodes) {
-			kormap_string += w;
-		}
+		RetrieveExPatchChars(PatchDir(patch_dir_path), scope_min, scope_max, w_keycodes);
+		kormap_string = w_keycodes.Chars();
 	}
 
 	std::wstring ansimap_string;
 	{
-		std::set<uint8_t> ansi_map;
+		CharSet ansi_map;
 		RetriveAnsiChars(ansi_map);
-		ansimap_string.reserve(ansi_map.size() + 10);
-		for (auto& ch : ansi_map) {
-			ansimap_string += ch;
-		}
+		ansimap_string = ansi_map.Chars();
 	}
 
 	std::wofstream wof;
-	wof.imbue(std::locale(std::locale::empty(), new std::codecvt_utf8<wchar_t, 0x10ffff, std::generate_header>));
-	wof.open(dst_file_path.wstring().c_str());
+	wof.imbue(std::locale(std::locale::classic(), new std::codecvt_utf8<wchar_t, 0x10ffff, std::generate_header>));
+	wof.open(dst_file_path);
 	wof << ansimap_string;
 	wof << kormap_string;
 	wof.close();
@@ -166,43 +166,30 @@ bool SirTool::GeneratePatchFontData(const fs::path& org_dir_path, const fs::path
 
 	ReadSirDir(org_dir_path);
 
-	for (auto i : fs::recursive_directory_iterator{ patch_dir_path }) {
-		auto ip = i.path();
-		if (i.is_regular_file() && ip.extension() == ".xml") {
-			if (!StrCmpEndWith(ip.string(), SirFont::XmlExtension)) {
-				ReadXml(ip, patch_set);
-			}
-		}
+	if (!ReadPatchTexts(patch_dir_path, patch_set)) {
+		return false;
 	}
 
 	std::array<fs::path, 2> bmf_path = { bmf_default_path, bmf_border_path };
 	std::array<BMFont, 2> bmf;
-	std::array<std::vector<std::vector<uint8_t>>, 2> png_buffer;
-	std::array<uint32_t, 2> png_width{};
-	std::array<uint32_t, 2> png_height{};
-	std::array<uint32_t, 2> ch_width{};
-	std::array<uint32_t, 2> ch_height{};
-
+	std::array<uint64_t, 2> bmf_hash{};
 	for (int i = 0; i < 2; i++) {
-		BMFontXmlReader::Read(bmf_path[i], bmf[i]);
-		ch_width[i] = bmf[i].GetCharMaxWidthForRender();
-		ch_height[i] = bmf[i].common.lineHeight;
-		png_buffer[i].resize(bmf[i].pages.size());
-		int pcount = 0;
+		if (!BMFontReader::Read(bmf_path[i], bmf[i])) {
+			return false;
+		}
+		// the descriptor and its pages, a glyph of the cache is only valid for the same files.
+		bmf_hash[i] = HashFile(bmf_path[i]);
 		for (auto& p : bmf[i].pages) {
-			PngReader::Read(bmf_path[i].parent_path().append(p.file), png_width[i], png_height[i], png_buffer[i][pcount]);
-			pcount++;
+			bmf_hash[i] = HashString(p.file, bmf_hash[i]);
+			bmf_hash[i] = HashFile(bmf_path[i].parent_path().append(p.file), bmf_hash[i]);
 		}
 	}
 
 	JpKeycodeAllocator keycode_alloc(0xF0, 0x00);
-	char temp_jp_char[3] = {};
 	for (auto& s : org_set.fonts) {
 		for (auto& n : s->nodes) {
 			if (n->keycode[1] != 0) {
-				temp_jp_char[0] = n->keycode[1];
-				temp_jp_char[1] = n->keycode[0];
-				keycode_alloc.jp_map.emplace(temp_jp_char);
+				keycode_alloc.Reserve((uint8_t)n->keycode[1], (uint8_t)n->keycode[0]);
 			}
 		}
 	}
@@ -211,82 +198,216 @@ bool SirTool::GeneratePatchFontData(const fs::path& org_dir_path, const fs::path
 	wchar_t scope_min = 0xAC00;
 	wchar_t scope_max = 0xD7AF;
 
-	std::array<int, 2> min_yoffsets = { bmf[0].GetCharMinYoffset(), bmf[1].GetCharMinYoffset() };
-
-	auto func_alloc_data = [&](std::shared_ptr<SirFont::Node>& fn, wchar_t ch) {
-		for (int i = 0; i < 2; i++) {
-			if (auto bmf_ch = stdext::FindPtr<BMFont::Char>(bmf[i].chars, [ch, &min_yoffsets](const auto& elm) { return elm.id == ch; })) {
-				int xoffset_mod = 0;
-				int yoffset_mod = 0;
-				if (bmf[i].force_offsets_to_zero) {
-					fn->wsize[i] = bmf_ch->width;
-					fn->hsize[i] = bmf_ch->height;
-				}
-				else {
-					xoffset_mod = std::max(bmf_ch->xoffset + (int)bmf[i].info.padding[3], 0);
-					yoffset_mod = std::max(bmf_ch->yoffset - min_yoffsets[i], 0);
-					fn->wsize[i] = std::max(xoffset_mod + bmf_ch->width, bmf_ch->xadvance + bmf[i].info.padding[1] + bmf[i].info.padding[3]);
-					fn->hsize[i] = yoffset_mod + bmf_ch->height;
-				}
-				fn->data[i].resize(fn->wsize[i] * fn->hsize[i], 0);
-				auto& src_buf = png_buffer[i][bmf_ch->page];
-
-				for (int y = 0; y < bmf_ch->height; y++) {
-					for (int x = 0; x < bmf_ch->width; x++) {
-						fn->data[i][(yoffset_mod + y) * fn->wsize[i] + xoffset_mod + x] = src_buf[(bmf_ch->y + y) * png_width[i] + bmf_ch->x + x];
-					}
-				}
-			}
-			else {
-				fn->wsize[i] = ch_width[i];
-				fn->hsize[i] = ch_height[i];
-				fn->data[i].resize(ch_width[i] * ch_height[i], 0);
-			}
-		}
-	};
-
 	SirFont new_f;
+	std::vector<wchar_t> node_chars;
 
-	std::set<uint8_t> ansi_map;
+	CharSet ansi_map;
 	RetriveAnsiChars(ansi_map);
-	for (auto& ch : ansi_map) {
+	for (auto ch : ansi_map.Chars()) {
 		auto fn = std::make_shared<SirFont::Node>();
 		fn->keycode[0] = (char)ch;
-		func_alloc_data(fn, ch);
 		new_f.nodes.push_back(fn);
+		node_chars.push_back(ch);
 	}
 
-	std::set<wchar_t> w_keycodes;
-	RetrievePatchChars(scope_min, scope_max, w_keycodes);
-	RetrieveExPatchChars(patch_dir_path, scope_min, scope_max, w_keycodes);
+	CharSet w_keycode_set;
+	RetrievePatchChars(scope_min, scope_max, w_keycode_set);
+	RetrieveExPatchChars(PatchDir(patch_dir_path), scope_min, scope_max, w_keycode_set);
+	auto w_keycodes = w_keycode_set.Chars();
+	auto codes = keycode_alloc.Alloc(w_keycodes.size());
+	if (codes.size() < w_keycodes.size()) {
+		return false;
+	}
+	auto code_it = codes.begin();
 	for (auto& w : w_keycodes) {
-		keycode_alloc.Alloc();
+		auto code = *code_it++;
 		auto fn = std::make_shared<SirFont::Node>();
-		fn->keycode[0] = keycode_alloc.keycode[1];
-		fn->keycode[1] = keycode_alloc.keycode[0];
+		fn->keycode[0] = (char)(code & 0xFF);
+		fn->keycode[1] = (char)(code >> 8);
 		fn->patch_keycode = wcs_to_utf8(std::wstring(1, w));
-		func_alloc_data(fn, w);
 		new_f.nodes.push_back(fn);
+		node_chars.push_back(w);
 	}
 
 	if (!fs::exists(dst_dir_path)) {
 		fs::create_directory(dst_dir_path);
 	}
 
+	// glyphs of the last run are taken as they are, only the ones not found there are cut out of the pages.
+	auto cache_path = fs::path(dst_dir_path).append(GlyphCache::FileName);
+	GlyphCache cache;
+	cache.Open(cache_path);
+	auto func_cache_key = [&](std::size_t n, int i) {
+		return GlyphCache::Key{ bmf_hash[i], (uint32_t)node_chars[n], (uint32_t)i };
+	};
+	std::vector<std::array<std::optional<GlyphCache::Glyph>, 2>> cached(new_f.nodes.size());
+	bool all_cached = true;
+	for (std::size_t n = 0; n < new_f.nodes.size(); n++) {
+		for (int i = 0; i < 2; i++) {
+			cached[n][i] = cache.Find(func_cache_key(n, i));
+			all_cached = all_cached && cached[n][i].has_value();
+		}
+	}
+
+	std::array<std::vector<std::vector<uint8_t>>, 2> png_buffer;
+	std::array<std::vector<uint32_t>, 2> png_width;
+	std::array<std::vector<uint32_t>, 2> png_height;
+	std::array<uint32_t, 2> ch_width{};
+	std::array<uint32_t, 2> ch_height{};
+	std::array<int, 2> min_yoffsets{};
+	if (!all_cached) {
+		// the pages of both fonts are decoded at the same time.
+		std::vector<std::pair<int, std::size_t>> pages;
+		for (int i = 0; i < 2; i++) {
+			ch_width[i] = bmf[i].GetCharMaxWidthForRender();
+			ch_height[i] = bmf[i].common.lineHeight;
+			min_yoffsets[i] = bmf[i].GetCharMinYoffset();
+			png_buffer[i].resize(bmf[i].pages.size());
+			png_width[i].resize(bmf[i].pages.size());
+			png_height[i].resize(bmf[i].pages.size());
+			for (std::size_t p = 0; p < bmf[i].pages.size(); p++) {
+				pages.emplace_back(i, p);
+			}
+		}
+		std::atomic<bool> pages_read = true;
+		ThreadPool::Shared().ParallelFor(pages.size(), [&](std::size_t k) {
+			auto [i, p] = pages[k];
+			if (!PngReader::Read(bmf_path[i].parent_path().append(bmf[i].pages[p].file), png_width[i][p], png_height[i][p], png_buffer[i][p])) {
+				pages_read = false;
+			}
+		});
+		if (!pages_read) {
+			return false;
+		}
+	}
+
+	// where a glyph sits in its node, (0, 0) when the bitmaps are used as they are.
+	auto func_glyph_offsets = [&](int i, const BMFont::Char* bmf_ch) {
+		if (bmf[i].force_offsets_to_zero) {
+			return std::pair<int, int>(0, 0);
+		}
+		return std::pair<int, int>(std::max(bmf_ch->xoffset + (int)bmf[i].info.padding[3], 0), std::max(bmf_ch->yoffset - min_yoffsets[i], 0));
+	};
+
+	// sizes first, the font arenas are laid out from them before any pixel is copied.
+	auto func_alloc_data = [&](SirFont::Node& fn, wchar_t ch, int i) {
+		if (auto bmf_ch = bmf[i].FindChar(ch)) {
+			auto [xoffset_mod, yoffset_mod] = func_glyph_offsets(i, bmf_ch);
+			if (bmf[i].force_offsets_to_zero) {
+				fn.wsize[i] = bmf_ch->width;
+				fn.hsize[i] = bmf_ch->height;
+			}
+			else {
+				fn.wsize[i] = std::max(xoffset_mod + bmf_ch->width, bmf_ch->xadvance + bmf[i].info.padding[1] + bmf[i].info.padding[3]);
+				fn.hsize[i] = yoffset_mod + bmf_ch->height;
+			}
+		}
+		else {
+			fn.wsize[i] = ch_width[i];
+			fn.hsize[i] = ch_height[i];
+		}
+	};
+	// false when the char doesn't fit its decoded page or its node.
+	auto func_copy_data = [&](SirFont& f, const SirFont::Node& fn, wchar_t ch, int i) {
+		if (auto bmf_ch = bmf[i].FindChar(ch)) {
+			auto [xoffset_mod, yoffset_mod] = func_glyph_offsets(i, bmf_ch);
+			std::size_t page_width = png_width[i][bmf_ch->page];
+			std::size_t page_height = png_height[i][bmf_ch->page];
+			if (bmf_ch->width > page_width || bmf_ch->x > page_width - bmf_ch->width ||
+				bmf_ch->height > page_height || bmf_ch->y > page_height - bmf_ch->height) {
+				return false;
+			}
+			if (xoffset_mod + bmf_ch->width > fn.wsize[i] || yoffset_mod + bmf_ch->height > fn.hsize[i]) {
+				return false;
+			}
+			auto dst = f.Pixels(fn, i).data();
+			auto& src_buf = png_buffer[i][bmf_ch->page];
+
+			for (int y = 0; y < bmf_ch->height; y++) {
+				memcpy(dst + (yoffset_mod + y) * fn.wsize[i] + xoffset_mod, src_buf.data() + (bmf_ch->y + y) * page_width + bmf_ch->x, bmf_ch->width);
+			}
+		}
+		return true;
+	};
+
+	for (std::size_t n = 0; n < new_f.nodes.size(); n++) {
+		auto& fn = *new_f.nodes[n];
+		for (int i = 0; i < 2; i++) {
+			if (auto& glyph = cached[n][i]) {
+				fn.wsize[i] = glyph->width;
+				fn.hsize[i] = glyph->height;
+			}
+			else {
+				func_alloc_data(fn, node_chars[n], i);
+			}
+			new_f.AllocPixels(fn, i);
+		}
+	}
+	// every node has its own range of the arenas, the fonts, pages and cache are only read.
+	std::atomic<bool> glyphs_copied = true;
+	ThreadPool::Shared().ParallelFor(new_f.nodes.size(), [&](std::size_t n) {
+		auto& fn = *new_f.nodes[n];
+		for (int i = 0; i < 2; i++) {
+			if (auto& glyph = cached[n][i]) {
+				std::copy(glyph->pixels.begin(), glyph->pixels.end(), new_f.Pixels(fn, i).begin());
+			}
+			else if (!func_copy_data(new_f, fn, node_chars[n], i)) {
+				glyphs_copied = false;
+			}
+		}
+	});
+	if (!glyphs_copied) {
+		return false;
+	}
+
+	// identical glyphs (blank ones, the boxes of chars the fonts lack) are kept and packed into the pages once.
+	new_f.SharePixels();
+
+	// the cache is rewritten with the glyphs of this run, it is mapped until then.
+	std::vector<GlyphCache::Entry> cache_entries;
+	for (std::size_t n = 0; n < new_f.nodes.size(); n++) {
+		auto& fn = *new_f.nodes[n];
+		for (int i = 0; i < 2; i++) {
+			cache_entries.push_back({ func_cache_key(n, i), { fn.wsize[i], fn.hsize[i], new_f.Pixels(fn, i) } });
+		}
+	}
+	cache.Close();
+	if (!GlyphCache::Write(cache_path, std::move(cache_entries))) {
+		return false;
+	}
+
+	// every font file gets the same glyphs, so each page is laid out and encoded once, both at the same time.
+	std::array<SirPngWriter::Atlas, 2> atlas;
+	std::array<std::vector<uint8_t>, 2> png_files;
+	ThreadPool::Shared().ParallelFor(2, [&](std::size_t i) {
+		atlas[i] = SirPngWriter::Layout(new_f, (int)i);
+		png_files[i] = SirPngWriter::Encode(new_f, (int)i, atlas[i], SirPngWriter::write_options);
+	});
+
 	for (auto& f : org_set.fonts) {
 		new_f.filename = f->filename;
 		new_f.footer_unknown_values = f->footer_unknown_values;
-		SirXmlWriter::Write(new_f, fs::path(dst_dir_path).append(new_f.filename + SirFont::XmlExtension));
-		SirPngWriter::Write(new_f, 0, fs::path(dst_dir_path).append(new_f.filename + SirFont::DefaultPngExtension));
-		SirPngWriter::Write(new_f, 1, fs::path(dst_dir_path).append(new_f.filename + SirFont::BorderPngExtension));
+		if (!SirXmlWriter::Write(new_f, atlas, fs::path(dst_dir_path).append(new_f.filename + SirFont::XmlExtension)) ||
+			!WriteFile(fs::path(dst_dir_path).append(new_f.filename + SirFont::DefaultPngExtension), png_files[0].data(), png_files[0].size()) ||
+			!WriteFile(fs::path(dst_dir_path).append(new_f.filename + SirFont::BorderPngExtension), png_files[1].data(), png_files[1].size())) {
+			return false;
+		}
 	}
 
 	return true;
 }
 
-void SirTool::RetrievePatchChars(wchar_t scope_min, wchar_t scope_max, std::set<wchar_t>& w_keycodes)
+void SirTool::RetrievePatchChars(wchar_t scope_min, wchar_t scope_max, CharSet& chars)
 {
-	for (auto& ps : patch_set.dlgs) {
+	// one scan per patch file, run on the thread pool into sets of their own.
+	std::vector<std::function<void(CharSet&)>> scans;
+	auto func_add = [&](auto& patch_sirs, auto func_scan) {
+		for (auto& ps : patch_sirs) {
+			scans.push_back([&ps, func_scan](CharSet& w_keycodes) { func_scan(ps, w_keycodes); });
+		}
+	};
+
+	func_add(patch_set.dlgs, [&](auto& ps, CharSet& w_keycodes) {
 		if (auto s = FindSirPtr(org_set.dlgs, ps->filename)) {
 			for (auto& pn : ps->nodes) {
 				if (auto n = stdext::FindPtr<SirDlg::Node>(s->nodes, [&pn](auto& an) {return an->Equal(*pn) && (an->text != pn->text); })) {
@@ -294,9 +415,9 @@ void SirTool::RetrievePatchChars(wchar_t scope_min, wchar_t scope_max, std::set<
 				}
 			}
 		}
-	}
+	});
 
-	for (auto& ps : patch_set.names) {
+	func_add(patch_set.names, [&](auto& ps, CharSet& w_keycodes) {
 		if (auto s = FindSirPtr(org_set.names, ps->filename)) {
 			for (auto& pn : ps->nodes) {
 				if (stdext::FindPtr<SirName::Node>(s->nodes, [&pn](auto& an) {return an->Equal(*pn) && an->name != pn->name; })) {
@@ -304,9 +425,9 @@ void SirTool::RetrievePatchChars(wchar_t scope_min, wchar_t scope_max, std::set<
 				}
 			}
 		}
-	}
+	});
 
-	for (auto& ps : patch_set.items) {
+	func_add(patch_set.items, [&](auto& ps, CharSet& w_keycodes) {
 		if (auto s = FindSirPtr(org_set.items, ps->filename)) {
 			for (auto& pn : ps->nodes) {
 				if (auto n = stdext::FindPtr<SirItem::Node>(s->nodes, [&pn](auto& an) {return an->Equal(*pn); })) {
@@ -318,9 +439,9 @@ void SirTool::RetrievePatchChars(wchar_t scope_min, wchar_t scope_max, std::set<
 				}
 			}
 		}
-	}
+	});
 
-	for (auto& ps : patch_set.msgs) {
+	func_add(patch_set.msgs, [&](auto& ps, CharSet& w_keycodes) {
 		if (auto s = FindSirPtr(org_set.msgs, ps->filename)) {
 			for (auto& pn : ps->nodes) {
 				if (auto n = stdext::FindPtr<SirMsg::Node>(s->nodes, [&pn](auto& an) {return an->Equal(*pn) && an->AllText() != pn->AllText(); })) {
@@ -330,9 +451,9 @@ void SirTool::RetrievePatchChars(wchar_t scope_min, wchar_t scope_max, std::set<
 				}
 			}
 		}
-	}
+	});
 
-	for (auto& ps : patch_set.descs) {
+	func_add(patch_set.descs, [&](auto& ps, CharSet& w_keycodes) {
 		if (auto s = FindSirPtr(org_set.descs, ps->filename)) {
 			for (auto& pt : ps->texts) {
 				if (auto t = stdext::FindPtr<SirDesc::Text>(s->texts, [&pt](auto& at) { return at->Equal(*pt) && at->value != pt->value; })) {
@@ -340,9 +461,9 @@ void SirTool::RetrievePatchChars(wchar_t scope_min, wchar_t scope_max, std::set<
 				}
 			}
 		}
-	}
+	});
 
-	for (auto& ps : patch_set.fcharts) {
+	func_add(patch_set.fcharts, [&](auto& ps, CharSet& w_keycodes) {
 		if (auto s = FindSirPtr(org_set.fcharts, ps->filename)) {
 			for (auto& pn : ps->nodes) {
 				if (auto n = stdext::FindPtr<SirFChart::Node>(s->nodes, [&pn](auto& an) { return an->Equal(*pn); })) {
@@ -363,9 +484,9 @@ void SirTool::RetrievePatchChars(wchar_t scope_min, wchar_t scope_max, std::set<
 				}
 			}
 		}
-	}
+	});
 
-	for (auto& ps : patch_set.docs) {
+	func_add(patch_set.docs, [&](auto& ps, CharSet& w_keycodes) {
 		if (auto s = FindSirPtr(org_set.docs, ps->filename)) {
 			for (auto& pn : ps->nodes) {
 				if (auto n = stdext::FindPtr<SirDoc::Node>(s->nodes, [&pn](auto& an) { return an->Equal(*pn) && an->AllText() != pn->AllText(); })) {
@@ -377,9 +498,9 @@ void SirTool::RetrievePatchChars(wchar_t scope_min, wchar_t scope_max, std::set<
 				}
 			}
 		}
-	}
+	});
 
-	for (auto& ps : patch_set.maps) {
+	func_add(patch_set.maps, [&](auto& ps, CharSet& w_keycodes) {
 		if (auto s = FindSirPtr(org_set.maps, ps->filename)) {
 			for (auto& pn : ps->nodes) {
 				if (auto n = stdext::FindPtr<SirMap::Node>(s->nodes, [&pn](auto& an) {return an->Equal(*pn); })) {
@@ -391,9 +512,9 @@ void SirTool::RetrievePatchChars(wchar_t scope_min, wchar_t scope_max, std::set<
 				}
 			}
 		}
-	}
+	});
 
-	for (auto& ps : patch_set.credits) {
+	func_add(patch_set.credits, [&](auto& ps, CharSet& w_keycodes) {
 		if (auto s = FindSirPtr(org_set.credits, ps->filename)) {
 			for (auto& pn : ps->nodes) {
 				if (auto n = stdext::FindPtr<SirCredit::Node>(s->nodes, [&pn](auto& an) {return an->Equal(*pn); })) {
@@ -405,9 +526,9 @@ void SirTool::RetrievePatchChars(wchar_t scope_min, wchar_t scope_max, std::set<
 				}
 			}
 		}
-	}
+	});
 
-	for (auto& ps : patch_set.rooms) {
+	func_add(patch_set.rooms, [&](auto& ps, CharSet& w_keycodes) {
 		if (auto s = FindSirPtr(org_set.rooms, ps->filename)) {
 			for (auto& pn : ps->nodes) {
 				if (auto n = stdext::FindPtr<SirRoom::Node>(s->nodes, [&pn](auto& an) {return an->Equal(*pn); })) {
@@ -419,49 +540,41 @@ void SirTool::RetrievePatchChars(wchar_t scope_min, wchar_t scope_max, std::set<
 				}
 			}
 		}
-	}
+	});
+
+	chars |= CharSet::Collect(scans.size(), [&](std::size_t i, CharSet& w_keycodes) { scans[i](w_keycodes); });
 }
 
-void SirTool::RetrieveExPatchChars(const fs::path& patch_dir_path, wchar_t scope_min, wchar_t scope_max, std::set<wchar_t>& w_keycodes)
+void SirTool::RetrieveExPatchChars(const fs::path& patch_dir_path, wchar_t scope_min, wchar_t scope_max, CharSet& chars)
 {
+	std::vector<fs::path> exe_xml_paths;
 	for (auto i : fs::recursive_directory_iterator{ patch_dir_path }) {
 		auto ip = i.path();
-		if (i.is_regular_file() && ip.extension() == ".xml") {
-			if (StrCmpEndWith(ip.string(), ".exe.xml")) {
-
-				std::map<std::string, std::string> map;
-				ReadExePatchFile(i, map);
-				for (auto& p : map)
-				{
-					auto wtext = utf8_to_wcs(p.second);
-					auto modlen = wtext.length();
-					for (std::size_t i = 0; i < modlen; i++) {
-						if (wtext[i] >= scope_min && wtext[i] <= scope_max) {
-							w_keycodes.insert(wtext[i]);
-						}
-					}
-				}
-
-			}
+		if (i.is_regular_file() && ip.extension() == ".xml" && StrCmpEndWith(ip.string(), ".exe.xml")) {
+			exe_xml_paths.push_back(ip);
 		}
 	}
+
+	chars |= CharSet::Collect(exe_xml_paths.size(), [&](std::size_t i, CharSet& w_keycodes) {
+		std::map<std::string, std::string> map;
+		ReadExePatchFile(exe_xml_paths[i], map);
+		std::wstring wtext;
+		for (auto& p : map) {
+			utf8_to_wcs(p.second, wtext);
+			w_keycodes.Insert(wtext, scope_min, scope_max);
+		}
+	});
 }
 
-void SirTool::RetrievePatchChars(const std::wstring& text, wchar_t scope_min, wchar_t scope_max, std::set<wchar_t>& w_keycodes)
+void SirTool::RetrievePatchChars(const std::wstring& text, wchar_t scope_min, wchar_t scope_max, CharSet& w_keycodes)
 {
-	auto modlen = text.length();
-	for (std::size_t i = 0; i < modlen; i++) {
-		if (text[i] >= scope_min && text[i] <= scope_max) {
-			w_keycodes.insert(text[i]);
-		}
-	}
+	w_keycodes.Insert(text, scope_min, scope_max);
 }
 
 void SirTool::ReadExePatchFile(const fs::path& file_path, std::map<std::string, std::string>& map)
 {
-	rapidxml::file<char> xmlFile(file_path.string().c_str()); // Default template is char
-	rapidxml::xml_document<char> doc;
-	doc.parse<0>(xmlFile.data());
+	XmlFile doc(file_path);
+	std::string scratch;
 
 	auto node_dlgs = doc.first_node();
 	auto node_dlg = node_dlgs->first_node();
@@ -470,13 +583,13 @@ void SirTool::ReadExePatchFile(const fs::path& file_path, std::map<std::string,
 		std::string org_text;
 		std::string new_text;
 		while (attr_dlg != nullptr) {
-			if (strcmp(attr_dlg->name(), "org") == 0) {
-				auto hbytes = HexStringToBytes(attr_dlg->value());
+			if (XmlName(attr_dlg) == "org") {
+				auto hbytes = HexStringToBytes(std::string(XmlValue(attr_dlg, scratch)));
 				hbytes.push_back(0);
 				org_text = (const char*)hbytes.data();
 			}
-			else if (strcmp(attr_dlg->name(), "new") == 0) {
-				new_text = attr_dlg->value();
+			else if (XmlName(attr_dlg) == "new") {
+				new_text = XmlValue(attr_dlg, scratch);
 			}
 			attr_dlg = attr_dlg->next_attribute();
 		}
@@ -488,56 +601,140 @@ void SirTool::ReadExePatchFile(const fs::path& file_path, std::map<std::string,
 	}
 }
 
-void SirTool::RetriveAnsiChars(std::set<uint8_t>& ansi_map)
+void SirTool::RetriveAnsiChars(CharSet& ansi_map)
 {
-	for (auto& s : org_set.fonts) {
-		for (auto& n : s->nodes) {
+	ansi_map |= CharSet::Collect(org_set.fonts.size(), [&](std::size_t i, CharSet& chars) {
+		for (auto& n : org_set.fonts[i]->nodes) {
 			if (n->keycode[1] == 0) {
 				if ((uint8_t)n->keycode[0] <= 0x7E) {
-					ansi_map.insert((uint8_t)n->keycode[0]);
+					chars.Insert((uint8_t)n->keycode[0]);
 				}
 			}
 		}
-	}
+	});
 }
 
 std::string SirTool::PatchText(const std::wstring& text)
 {
-	std::wstring fwtext;
-	auto wlen = text.length();
-	fwtext.reserve(wlen + 10);
-
-	for (std::size_t i = 0; i < wlen; i++) {
-		auto it = patch_glyphs.find(text[i]);
-		if (it == patch_glyphs.end()) {
-			fwtext += text[i];
-			continue;
-		}
-		fwtext += it->second;
-	}
-
-	return wcs_to_mbs(fwtext, "");
+	std::string ftext;
+	patch_glyphs.Transcode(text, ftext);
+	return ftext;
 }
 
 bool SirTool::Patch(const fs::path& org_dir_path, const fs::path& patch_dir_path, std::string option, const fs::path& dst_dir_path)
 {
-	if (!fs::is_directory(org_dir_path) || !fs::is_directory(patch_dir_path) || !fs::is_directory(dst_dir_path)) {
+	// with a translation store the texts come from the store, fonts and jpchars.txt from the directory it is in.
+	SirStore store;
+	auto use_store = SirStore::IsStorePath(patch_dir_path);
+	auto patch_files_path = PatchDir(patch_dir_path);
+	if (use_store && !store.Open(patch_dir_path)) {
 		return false;
 	}
 
-	ReadSirDir(org_dir_path);
+	if (!fs::is_directory(org_dir_path) || !fs::is_directory(patch_files_path) || !fs::is_directory(dst_dir_path)) {
+		return false;
+	}
 
-	for (auto i : fs::recursive_directory_iterator{ patch_dir_path }) {
+	std::map<std::string, fs::path> org_paths;
+	for (auto i : fs::recursive_directory_iterator{ org_dir_path }) {
+		if (i.is_regular_file() && i.path().extension() == ".sir") {
+			org_paths.emplace(i.path().stem().string(), i.path());
+		}
+	}
+
+	std::vector<fs::path> font_xml_paths;
+	std::vector<fs::path> text_xml_paths;
+	for (auto i : fs::recursive_directory_iterator{ patch_files_path }) {
 		if (i.is_regular_file()) {
 			if (i.path().extension() == ".xml") {
-				ReadXml(i.path(), patch_set);
+				if (StrCmpEndWith(i.path().filename().string(), SirFont::XmlExtension)) {
+					font_xml_paths.push_back(i.path());
+				}
+				else if (!use_store) {
+					text_xml_paths.push_back(i.path());
+				}
 			}
 		}
 	}
+	std::sort(font_xml_paths.begin(), font_xml_paths.end());
+
+	auto jpchars_path = fs::path(patch_files_path).append("jpchars.txt");
+
+	// every patched text depends on the glyph map, so any font input change rebuilds everything.
+	PatchManifest manifest;
+	PatchManifest new_manifest;
+	auto manifest_path = fs::path(dst_dir_path).append(PatchManifest::FileName);
+	manifest.Read(manifest_path);
+
+	new_manifest.glyph_hash = HashString(option);
+	new_manifest.glyph_hash = HashFile(jpchars_path, new_manifest.glyph_hash);
+	for (auto& p : font_xml_paths) {
+		auto filename_without_ext = p.filename().string();
+		filename_without_ext.resize(filename_without_ext.length() - (sizeof(SirFont::XmlExtension) - 1));
+		new_manifest.glyph_hash = HashString(p.filename().string(), new_manifest.glyph_hash);
+		new_manifest.glyph_hash = HashFile(p, new_manifest.glyph_hash);
+		new_manifest.glyph_hash = HashFile(fs::path(p.parent_path()).append(filename_without_ext + SirFont::DefaultPngExtension), new_manifest.glyph_hash);
+		new_manifest.glyph_hash = HashFile(fs::path(p.parent_path()).append(filename_without_ext + SirFont::BorderPngExtension), new_manifest.glyph_hash);
+	}
+	auto rebuild_all = (manifest.glyph_hash != new_manifest.glyph_hash);
+
+	std::unordered_set<std::string> rebuild_filenames;
+	auto func_check_input = [&](const std::string& filename, auto func_hash_input) {
+		auto it = org_paths.find(filename);
+		if (it == org_paths.end()) {
+			return false;
+		}
+
+		auto hash = func_hash_input(HashFile(it->second));
+		new_manifest.entries[filename] = hash;
+		if (!rebuild_all && manifest.IsUpToDate(filename, hash) && fs::exists(fs::path(dst_dir_path).append(filename + ".sir"))) {
+			unchanged_count++;
+			return false;
+		}
+		rebuild_filenames.insert(filename);
+		return true;
+	};
+
+	std::vector<fs::path> rebuild_xml_paths;
+	std::vector<SirStore::FileRef> rebuild_store_files;
+	for (auto& p : font_xml_paths) {
+		func_check_input(p.stem().stem().string(), [&](uint64_t seed) { return HashFile(p, seed); });
+	}
+	for (auto& p : text_xml_paths) {
+		if (func_check_input(p.stem().stem().string(), [&](uint64_t seed) { return HashFile(p, seed); })) {
+			rebuild_xml_paths.push_back(p);
+		}
+	}
+	for (std::size_t i = 0; i < store.FileCount(); i++) {
+		auto file = store.File(i);
+		if (func_check_input(file.Stem(), [&](uint64_t seed) { return file.Hash(seed); })) {
+			rebuild_store_files.push_back(file);
+		}
+	}
+
+	if (rebuild_filenames.empty()) {
+		return new_manifest.Write(manifest_path);
+	}
+
+	// patch fonts are always needed to build the glyph map.
+	for (auto& p : font_xml_paths) {
+		auto it = org_paths.find(p.stem().stem().string());
+		if (it != org_paths.end()) {
+			ReadSirFile(it->second);
+		}
+		ReadXml(p, patch_set);
+	}
+	for (auto& p : rebuild_xml_paths) {
+		ReadSirFile(org_paths[p.stem().stem().string()]);
+		ReadXml(p, patch_set);
+	}
+	for (auto& f : rebuild_store_files) {
+		ReadSirFile(org_paths[f.Stem()]);
+		ReadStoreFile(f, patch_set);
+	}
 
 	{
 		std::wstring keep_jpchars;
-		auto jpchars_path = fs::path(patch_dir_path).append("jpchars.txt");
 		if (fs::exists(jpchars_path)) {
 			std::vector<uint8_t> buffer;
 			buffer.resize(fs::file_size(jpchars_path) + 1, 0);
@@ -545,16 +742,23 @@ bool SirTool::Patch(const fs::path& org_dir_path, const fs::path& patch_dir_path
 			std::u8string ustr((char8_t*)buffer.data());
 			keep_jpchars = utf8_to_wcs(std::string((char*)buffer.data()));
 		}
+		// <size> or <size>:box
 		auto mod_size = (std::size_t)std::atoi(option.c_str());
+		auto filter = StrCmpEndWith(option, ":box") ? GlyphScaler::Filter::Box : GlyphScaler::Filter::Nearest;
 
 		if (mod_size > 0) {
+			GlyphScaler scaler(mod_size, filter);
 			for (auto& f : org_set.fonts) {
-				f->ReduceKanjiSize(keep_jpchars, mod_size);
+				if (rebuild_filenames.contains(f->filename)) {
+					f->ReduceKanjiSize(keep_jpchars, scaler);
+				}
 			}
 		}
 		else if (mod_size == 0) {
 			for (auto& f : org_set.fonts) {
-				f->RemoveKanji(keep_jpchars);
+				if (rebuild_filenames.contains(f->filename)) {
+					f->RemoveKanji(keep_jpchars);
+				}
 			}
 		}
 	}
@@ -571,21 +775,24 @@ bool SirTool::Patch(const fs::path& org_dir_path, const fs::path& patch_dir_path
 	std::vector<SirCredit*> patched_credits;
 	std::vector<SirRoom*> patched_rooms;
 
+	patch_glyphs.Build();
 	for (auto& ps : patch_set.fonts) {
 		if (auto s = FindSirPtr(org_set.fonts, ps->filename)) {
 			for (auto& pn : ps->nodes) {
 				if (pn->keycode[1] == 0) {
 					auto idx = stdext::FindIdx(s->nodes, [&pn](auto& elm) { return elm->keycode[1] == 0 && elm->keycode[0] == pn->keycode[0]; });
 					if (idx >= 0) {
-						s->nodes[idx] = pn;
+						s->nodes[idx] = s->Import(*ps, *pn);
 					}
 				}
 				else {
-					patch_glyphs.emplace(utf8_to_wcs(pn->patch_keycode).front(), mbs_to_wcs(pn->SjisString(), L"").front());
-					s->nodes.push_back(pn);
+					patch_glyphs.Remap(utf8_to_wcs(pn->patch_keycode).front(), pn->SjisString());
+					s->nodes.push_back(s->Import(*ps, *pn));
 				}
 			}
-			patched_fonts.push_back(s);
+			if (rebuild_filenames.contains(s->filename)) {
+				patched_fonts.push_back(s);
+			}
 		}
 	}
 
@@ -734,19 +941,24 @@ bool SirTool::Patch(const fs::path& org_dir_path, const fs::path& patch_dir_path
 		fs::create_directory(dst_dir_path);
 	}
 
-	SirWriter::WriteAll(patched_dlgs, dst_dir_path);
-	SirWriter::WriteAll(patched_names, dst_dir_path);
-	SirWriter::WriteAll(patched_fonts, dst_dir_path);
-	SirWriter::WriteAll(patched_items, dst_dir_path);
-	SirWriter::WriteAll(patched_msgs, dst_dir_path);
-	SirWriter::WriteAll(patched_descs, dst_dir_path);
-	SirWriter::WriteAll(patched_fcharts, dst_dir_path);
-	SirWriter::WriteAll(patched_docs, dst_dir_path);
-	SirWriter::WriteAll(patched_maps, dst_dir_path);
-	SirWriter::WriteAll(patched_credits, dst_dir_path);
-	SirWriter::WriteAll(patched_rooms, dst_dir_path);
+	// a file that can't be written must not be recorded as up to date, so the manifest is left as it was.
+	bool written = true;
+	written = SirWriter::WriteAll(patched_dlgs, dst_dir_path) && written;
+	written = SirWriter::WriteAll(patched_names, dst_dir_path) && written;
+	written = SirWriter::WriteAll(patched_fonts, dst_dir_path) && written;
+	written = SirWriter::WriteAll(patched_items, dst_dir_path) && written;
+	written = SirWriter::WriteAll(patched_msgs, dst_dir_path) && written;
+	written = SirWriter::WriteAll(patched_descs, dst_dir_path) && written;
+	written = SirWriter::WriteAll(patched_fcharts, dst_dir_path) && written;
+	written = SirWriter::WriteAll(patched_docs, dst_dir_path) && written;
+	written = SirWriter::WriteAll(patched_maps, dst_dir_path) && written;
+	written = SirWriter::WriteAll(patched_credits, dst_dir_path) && written;
+	written = SirWriter::WriteAll(patched_rooms, dst_dir_path) && written;
+	if (!written) {
+		return false;
+	}
 
-	return true;
+	return new_manifest.Write(manifest_path);
 }
 
 bool SirTool::ExePatch(const fs::path& org_dir_path, const fs::path& patch_dir_path, const fs::path& exe_file_path, const fs::path& dst_dir_path)
@@ -770,6 +982,7 @@ bool SirTool::ExePatch(const fs::path& org_dir_path, const fs::path& patch_dir_p
 
 	std::vector<SirFont*> patched_fonts;
 
+	patch_glyphs.Build();
 	for (auto& ps : patch_set.fonts) {
 		auto f = FindSirPtr(org_set.fonts, ps->filename);
 		if (f == nullptr) {
@@ -780,72 +993,87 @@ bool SirTool::ExePatch(const fs::path& org_dir_path, const fs::path& patch_dir_p
 			if (pn->keycode[1] == 0) {
 				auto idx = stdext::FindIdx(f->nodes, [&pn](auto& elm) { return elm->keycode[1] == 0 && elm->keycode[0] == pn->keycode[0]; });
 				if (idx >= 0) {
-					f->nodes[idx] = pn;
+					f->nodes[idx] = f->Import(*ps, *pn);
 				}
 			}
 			else {
-				patch_glyphs.emplace(utf8_to_wcs(pn->patch_keycode).front(), mbs_to_wcs(pn->SjisString(), L"").front());
-				f->nodes.push_back(pn);
+				patch_glyphs.Remap(utf8_to_wcs(pn->patch_keycode).front(), pn->SjisString());
+				f->nodes.push_back(f->Import(*ps, *pn));
 			}
 		}
 		patched_fonts.push_back(f);
 	}
 
 
+	std::map<std::string, std::string> utf8_map;
 	std::map<std::string, std::string> replace_map;
 	{
-		std::map<std::string, std::string> temp_map;
-		ReadExePatchFile(xml_file_path, temp_map);
-		for (auto& p : temp_map)
+		ReadExePatchFile(xml_file_path, utf8_map);
+		std::wstring wtext;
+		std::string ftext;
+		for (auto& p : utf8_map)
 		{
-			auto wtext = utf8_to_wcs(p.second);
-			auto wlen = wtext.length();
-
-			std::wstring fwtext;
-			fwtext.reserve(wlen + 10);
-
-			for (std::size_t i = 0; i < wlen; i++) {
-				auto it = patch_glyphs.find(wtext[i]);
-				if (it == patch_glyphs.end()) {
-					fwtext += wtext[i];
-					continue;
-				}
-				fwtext += it->second;
-			}
-
-			std::string ftext = wcs_to_mbs(fwtext, "");
-			if (!ftext.empty())
+			utf8_to_wcs(p.second, wtext);
+			if (patch_glyphs.Transcode(wtext, ftext) && !ftext.empty() && ftext.size() <= p.first.size())
 				replace_map.emplace(p.first, ftext);
 		}
 	}
 
+	std::vector<const std::pair<const std::string, std::string>*> replaces;
+	std::vector<std::string_view> patterns;
+	replaces.reserve(replace_map.size());
+	patterns.reserve(replace_map.size());
+	for (auto& p : replace_map) {
+		replaces.push_back(&p);
+		patterns.push_back(p.first);
+	}
+
+	AhoCorasick matcher;
+	matcher.Build(patterns);
+
 	std::vector<char> buffer;
 	buffer.resize(fs::file_size(exe_file_path));
 	::ReadFile(exe_file_path, buffer.data());
-	auto buffer_size = buffer.size();
 
-	for (std::size_t i = 0; i < buffer_size; )
-	{
-		std::size_t changed = 0;
-		for (auto& p : replace_map)
-		{
-			auto& org_text = p.first;
-			if (org_text.front() == buffer[i] && i + org_text.size() < buffer_size)
-			{
-				if (strncmp(org_text.c_str(), buffer.data() + i, org_text.size()) == 0)
-				{
-					memset(buffer.data() + i, 0, org_text.size());
-					memcpy(buffer.data() + i, p.second.c_str(), p.second.size());
-					changed = org_text.size();
-					break;
-				}
+	// only the initialized data sections hold the sjis strings, code/relocations/resources are left untouched.
+	PeFile pe;
+	std::vector<std::span<char>> scan_ranges;
+	if (pe.Read(buffer)) {
+		for (auto& sec : pe.sections) {
+			if (sec.IsStringData() && sec.raw_offset < buffer.size()) {
+				auto size = std::min<std::size_t>(sec.raw_size, buffer.size() - sec.raw_offset);
+				scan_ranges.push_back(std::span<char>(buffer.data() + sec.raw_offset, size));
 			}
 		}
-
-		if (changed)
-			i += changed;
-		else
-			i++;
+	}
+	else {
+		scan_ranges.push_back(buffer);
+	}
+
+	std::stringstream log;
+	std::vector<std::size_t> match_counts(replaces.size(), 0);
+	for (auto& range : scan_ranges) {
+		auto range_offset = (std::size_t)(range.data() - buffer.data());
+		for (auto& m : matcher.FindAll(range)) {
+			auto& p = *replaces[m.pattern];
+			auto offset = range_offset + m.pos;
+			memset(buffer.data() + offset, 0, m.size);
+			memcpy(buffer.data() + offset, p.second.c_str(), p.second.size());
+			match_counts[m.pattern]++;
+			exe_replaced_count++;
+
+			log << ValueToHexString(pe.sections.empty() ? (uint64_t)offset : pe.OffsetToVA(offset)) << "\t"
+				<< BytesToHexString(std::span<uint8_t>((uint8_t*)p.first.data(), p.first.size())) << "\t"
+				<< utf8_map[p.first] << "\n";
+		}
+	}
+	for (auto c : match_counts) {
+		if (c == 0) {
+			exe_unmatched_count++;
+		}
+		else if (c > 1) {
+			exe_duplicated_count++;
+		}
 	}
 
 	if (!fs::exists(dst_dir_path))
@@ -857,22 +1085,48 @@ bool SirTool::ExePatch(const fs::path& org_dir_path, const fs::path& patch_dir_p
 		return false;
 	}
 
+	std::ofstream ofs_log(fs::path(dst_dir_path).append(exe_file_path.filename().string() + ".log"), std::ios::binary);
+	ofs_log << log.rdbuf();
+
 	return true;
 }
 
 void SirTool::ReadSirDir(const fs::path& dir_path)
 {
-	for (auto i : fs::recursive_directory_iterator{ dir_path }) {
-		if (i.is_directory()) {
-			ReadSirDir(i);
-		}
-		else if (i.is_regular_file() && i.path().extension() == ".sir") {
-			ReadSirFile(i);
+	std::vector<fs::path> file_paths;
+	auto func_collect = [&](const fs::path& path, auto& func_collect) -> void {
+		for (auto i : fs::recursive_directory_iterator{ path }) {
+			if (i.is_directory()) {
+				func_collect(i, func_collect);
+			}
+			else if (i.is_regular_file() && i.path().extension() == ".sir") {
+				file_paths.push_back(i);
+			}
 		}
+	};
+	func_collect(dir_path, func_collect);
+
+	ReadSirFiles(file_paths, org_set);
+}
+
+// each file is read into a set of its own and appended in path order, so the result doesn't depend on thread timing.
+void SirTool::ReadSirFiles(const std::vector<fs::path>& file_paths, SirSet& set)
+{
+	std::vector<SirSet> sets(file_paths.size());
+	ThreadPool::Shared().ParallelFor(file_paths.size(), [&](std::size_t i) {
+		ReadSirFile(file_paths[i], sets[i]);
+	});
+	for (auto& s : sets) {
+		set.Append(std::move(s));
 	}
 }
 
 bool SirTool::ReadSirFile(const fs::path& file_path)
+{
+	return ReadSirFile(file_path, org_set);
+}
+
+bool SirTool::ReadSirFile(const fs::path& file_path, SirSet& set)
 {
 	auto file_size = fs::file_size(file_path);
 	if (file_size <= 20) // sir1 + footer_beg + footer_end
@@ -887,37 +1141,37 @@ bool SirTool::ReadSirFile(const fs::path& file_path)
 	try {
 		auto rbuffer = std::span(buffer.data(), file_size);
 		if (SirReader::IsValidDlg(rbuffer)) {
-			org_set.dlgs.push_back(SirReader::ReadDlg(file_path.stem().string(), rbuffer));
+			set.dlgs.push_back(SirReader::ReadDlg(file_path.stem().string(), rbuffer));
 		}
 		else if (SirReader::IsValidName(rbuffer)) {
-			org_set.names.push_back(SirReader::ReadName(file_path.stem().string(), rbuffer));
+			set.names.push_back(SirReader::ReadName(file_path.stem().string(), rbuffer));
 		}
 		else if (SirReader::IsValidFont(rbuffer)) {
-			org_set.fonts.push_back(SirReader::ReadFont(file_path.stem().string(), rbuffer));
+			set.fonts.push_back(SirReader::ReadFont(file_path.stem().string(), rbuffer));
 		}
 		else if (SirReader::IsValidItem(rbuffer)) {
-			org_set.items.push_back(SirReader::ReadItem(file_path.stem().string(), rbuffer));
+			set.items.push_back(SirReader::ReadItem(file_path.stem().string(), rbuffer));
 		}
 		else if (SirReader::IsValidMsg(rbuffer)) {
-			org_set.msgs.push_back(SirReader::ReadMsg(file_path.stem().string(), rbuffer));
+			set.msgs.push_back(SirReader::ReadMsg(file_path.stem().string(), rbuffer));
 		}
 		else if (SirReader::IsValidDesc(rbuffer)) {
-			org_set.descs.push_back(SirReader::ReadDesc(file_path.stem().string(), rbuffer));
+			set.descs.push_back(SirReader::ReadDesc(file_path.stem().string(), rbuffer));
 		}
 		else if (SirReader::IsValidFChart(rbuffer)) {
-			org_set.fcharts.push_back(SirReader::ReadFChart(file_path.stem().string(), rbuffer));
+			set.fcharts.push_back(SirReader::ReadFChart(file_path.stem().string(), rbuffer));
 		}
 		else if (SirReader::IsValidDoc(rbuffer)) {
-			org_set.docs.push_back(SirReader::ReadDoc(file_path.stem().string(), rbuffer));
+			set.docs.push_back(SirReader::ReadDoc(file_path.stem().string(), rbuffer));
 		}
 		else if (SirReader::IsValidMap(rbuffer)) {
-			org_set.maps.push_back(SirReader::ReadMap(file_path.stem().string(), rbuffer));
+			set.maps.push_back(SirReader::ReadMap(file_path.stem().string(), rbuffer));
 		}
 		else if (SirReader::IsValidCredit(rbuffer)) {
-			org_set.credits.push_back(SirReader::ReadCredit(file_path.stem().string(), rbuffer));
+			set.credits.push_back(SirReader::ReadCredit(file_path.stem().string(), rbuffer));
 		}
 		else if (SirReader::IsValidRoom(rbuffer)) {
-			org_set.rooms.push_back(SirReader::ReadRoom(file_path.stem().string(), rbuffer));
+			set.rooms.push_back(SirReader::ReadRoom(file_path.stem().string(), rbuffer));
 		}
 		else {
 			return false;
@@ -930,45 +1184,146 @@ bool SirTool::ReadSirFile(const fs::path& file_path)
 	return true;
 }
 
-void SirTool::ReadXml(const fs::path& file_path, SirSet& set)
+// every kind but fonts, src is an xml path or a file of a translation store.
+template<typename S>
+static bool ReadTextXml(const std::string& filename, const S& src, SirSet& set)
 {
-	auto filename = file_path.filename().string();
-
 	if (StrCmpEndWith(filename, SirDlg::XmlExtension)) {
-		set.dlgs.push_back(SirXmlReader::ReadDlg(file_path));
+		set.dlgs.push_back(SirXmlReader::ReadDlg(src));
 	}
 	else if (StrCmpEndWith(filename, SirName::XmlExtension)) {
-		set.names.push_back(SirXmlReader::ReadName(file_path));
-	}
-	else if (StrCmpEndWith(filename, SirFont::XmlExtension)) {
-		auto filename_without_ext = filename.substr(0, filename.length() - 9);
-		set.fonts.push_back(SirXmlReader::ReadFont(
-			file_path,
-			fs::path(file_path.parent_path()).append(filename_without_ext + SirFont::DefaultPngExtension),
-			fs::path(file_path.parent_path()).append(filename_without_ext + SirFont::BorderPngExtension)));
+		set.names.push_back(SirXmlReader::ReadName(src));
 	}
 	else if (StrCmpEndWith(filename, SirItem::XmlExtension)) {
-		set.items.push_back(SirXmlReader::ReadItem(file_path));
+		set.items.push_back(SirXmlReader::ReadItem(src));
 	}
 	else if (StrCmpEndWith(filename, SirMsg::XmlExtension)) {
-		set.msgs.push_back(SirXmlReader::ReadMsg(file_path));
+		set.msgs.push_back(SirXmlReader::ReadMsg(src));
 	}
 	else if (StrCmpEndWith(filename, SirDesc::XmlExtension)) {
-		set.descs.push_back(SirXmlReader::ReadDesc(file_path));
+		set.descs.push_back(SirXmlReader::ReadDesc(src));
 	}
 	else if (StrCmpEndWith(filename, SirFChart::XmlExtension)) {
-		set.fcharts.push_back(SirXmlReader::ReadFChart(file_path));
+		set.fcharts.push_back(SirXmlReader::ReadFChart(src));
 	}
 	else if (StrCmpEndWith(filename, SirDoc::XmlExtension)) {
-		set.docs.push_back(SirXmlReader::ReadDoc(file_path));
+		set.docs.push_back(SirXmlReader::ReadDoc(src));
 	}
 	else if (StrCmpEndWith(filename, SirMap::XmlExtension)) {
-		set.maps.push_back(SirXmlReader::ReadMap(file_path));
+		set.maps.push_back(SirXmlReader::ReadMap(src));
 	}
 	else if (StrCmpEndWith(filename, SirCredit::XmlExtension)) {
-		set.credits.push_back(SirXmlReader::ReadCredit(file_path));
+		set.credits.push_back(SirXmlReader::ReadCredit(src));
 	}
 	else if (StrCmpEndWith(filename, SirRoom::XmlExtension)) {
-		set.rooms.push_back(SirXmlReader::ReadRoom(file_path));
+		set.rooms.push_back(SirXmlReader::ReadRoom(src));
+	}
+	else {
+		return false;
+	}
+	return true;
+}
+
+void SirTool::ReadXml(const fs::path& file_path, SirSet& set)
+{
+	auto filename = file_path.filename().string();
+
+	if (StrCmpEndWith(filename, SirFont::XmlExtension)) {
+		auto filename_without_ext = filename.substr(0, filename.length() - 9);
+		set.fonts.push_back(SirXmlReader::ReadFont(
+			file_path,
+			fs::path(file_path.parent_path()).append(filename_without_ext + SirFont::DefaultPngExtension),
+			fs::path(file_path.parent_path()).append(filename_without_ext + SirFont::BorderPngExtension)));
+	}
+	else {
+		ReadTextXml(filename, file_path, set);
+	}
+}
+
+void SirTool::ReadXmls(const std::vector<fs::path>& file_paths, SirSet& set)
+{
+	std::vector<SirSet> sets(file_paths.size());
+	ThreadPool::Shared().ParallelFor(file_paths.size(), [&](std::size_t i) {
+		ReadXml(file_paths[i], sets[i]);
+	});
+	for (auto& s : sets) {
+		set.Append(std::move(s));
+	}
+}
+
+void SirTool::ReadStoreFile(const SirStore::FileRef& file, SirSet& set)
+{
+	ReadTextXml(fs::path(file.Name()).filename().string(), file, set);
+}
+
+void SirTool::ReadStore(const SirStore& store, SirSet& set)
+{
+	std::vector<SirSet> sets(store.FileCount());
+	ThreadPool::Shared().ParallelFor(store.FileCount(), [&](std::size_t i) {
+		ReadStoreFile(store.File(i), sets[i]);
+	});
+	for (auto& s : sets) {
+		set.Append(std::move(s));
+	}
+}
+
+bool SirTool::ReadPatchTexts(const fs::path& patch_path, SirSet& set)
+{
+	if (SirStore::IsStorePath(patch_path)) {
+		SirStore store;
+		if (!store.Open(patch_path)) {
+			return false;
+		}
+		ReadStore(store, set);
+		return true;
+	}
+
+	std::vector<fs::path> xml_paths;
+	for (auto i : fs::recursive_directory_iterator{ patch_path }) {
+		auto ip = i.path();
+		if (i.is_regular_file() && ip.extension() == ".xml" && !StrCmpEndWith(ip.string(), SirFont::XmlExtension)) {
+			xml_paths.push_back(ip);
+		}
+	}
+	ReadXmls(xml_paths, set);
+	return true;
+}
+
+fs::path SirTool::PatchDir(const fs::path& patch_path)
+{
+	return SirStore::IsStorePath(patch_path) ? patch_path.parent_path() : patch_path;
+}
+
+bool SirTool::PackStore(const fs::path& xml_dir_path, const fs::path& store_path)
+{
+	if (!fs::is_directory(xml_dir_path)) {
+		return false;
 	}
+
+	// fonts keep their png pages and the exe patch isn't a sir, both stay as files next to the store.
+	std::vector<fs::path> xml_paths;
+	for (auto i : fs::recursive_directory_iterator{ xml_dir_path }) {
+		auto filename = i.path().filename().string();
+		if (i.is_regular_file() && i.path().extension() == ".xml" && !StrCmpEndWith(filename, SirFont::XmlExtension) && !StrCmpEndWith(filename, ".exe.xml")) {
+			xml_paths.push_back(i.path());
+		}
+	}
+	if (!SirStore::Pack(xml_dir_path, xml_paths, store_path)) {
+		return false;
+	}
+	stored_count = xml_paths.size();
+	return true;
+}
+
+bool SirTool::UnpackStore(const fs::path& store_path, const fs::path& dst_dir_path)
+{
+	SirStore store;
+	if (!fs::is_directory(dst_dir_path) || !store.Open(store_path)) {
+		return false;
+	}
+	if (!store.Unpack(dst_dir_path)) {
+		return false;
+	}
+	stored_count = store.FileCount();
+	return true;
 }
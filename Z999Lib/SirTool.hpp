@@ -3,39 +3,199 @@
 #include "Common.hpp"
 #include "Sir.hpp"
 #include "BMFont.hpp"
+#include "SirStore.hpp"
+#include "GlyphCache.hpp"
 
 class JpKeycodeAllocator
 {
 public:
 	JpKeycodeAllocator(uint8_t h, uint8_t l) : keycode({ h ,l, 0 }) {}
 
+	void Reserve(uint8_t lead, uint8_t trail)
+	{
+		auto code = (uint16_t)((lead << 8) | trail);
+		used[code >> 6] |= 1ULL << (code & 63);
+	}
+
+	// next free double-byte code after the current keycode, nullptr when the code space is exhausted.
 	const char* Alloc()
 	{
-		do {
-			keycode[1]++;
-			if (keycode[1] == 0x00) {
-				keycode[0]++;
-				keycode[1] = 0x01;
-			}
-			if (keycode[0] == 0xFF) {
+		auto code = FindFree(Current() + 1);
+		if (code == 0) {
+			return nullptr;
+		}
+		Take(code);
+		return (const char*)keycode.data();
+	}
+
+	// reserves up to count codes at once, (lead << 8) | trail in ascending order.
+	std::vector<uint16_t> Alloc(std::size_t count)
+	{
+		std::vector<uint16_t> codes;
+		codes.reserve(count);
+		while (codes.size() < count) {
+			auto code = FindFree(Current() + 1);
+			if (code == 0) {
 				break;
 			}
+			Take(code);
+			codes.push_back(code);
+		}
+		return codes;
+	}
+
+	std::array<uint8_t, 3> keycode;
+
+private:
+	uint32_t Current() const
+	{
+		return ((uint32_t)keycode[0] << 8) | keycode[1];
+	}
+
+	void Take(uint16_t code)
+	{
+		Reserve((uint8_t)(code >> 8), (uint8_t)code);
+		keycode[0] = (uint8_t)(code >> 8);
+		keycode[1] = (uint8_t)code;
+	}
 
-			if (jp_map.contains((const char*)&keycode[0])) {
-				continue;
+	uint16_t FindFree(uint32_t from) const
+	{
+		auto& valid = sjis::double_byte_bitmap();
+		for (auto w = from >> 6; w < valid.size(); w++) {
+			auto bits = valid[w] & ~used[w];
+			if (w == (from >> 6)) {
+				bits &= ~0ULL << (from & 63);
+			}
+			if (bits != 0) {
+				return (uint16_t)((w << 6) | std::countr_zero(bits));
 			}
+		}
+		return 0;
+	}
 
-			if (sjis_valid((const char*)&keycode[0])) {
-				break;
+	sjis::code_bitmap used{};
+};
+
+// a set of utf-16 code units as 64K bits. sets filled apart are merged with |=.
+class CharSet
+{
+public:
+	void Insert(wchar_t ch)
+	{
+		bits[(uint16_t)ch >> 6] |= 1ULL << (ch & 63);
+	}
+	// the chars of text within [scope_min, scope_max]
+	void Insert(const std::wstring& text, wchar_t scope_min, wchar_t scope_max)
+	{
+		for (auto ch : text) {
+			if (ch >= scope_min && ch <= scope_max) {
+				Insert(ch);
 			}
+		}
+	}
+	bool Contains(wchar_t ch) const
+	{
+		return (bits[(uint16_t)ch >> 6] & (1ULL << (ch & 63))) != 0;
+	}
+
+	CharSet& operator|=(const CharSet& other)
+	{
+		for (std::size_t w = 0; w < bits.size(); w++) {
+			bits[w] |= other.bits[w];
+		}
+		return *this;
+	}
 
-		} while (true);
+	std::size_t Count() const
+	{
+		std::size_t count = 0;
+		for (auto w : bits) {
+			count += std::popcount(w);
+		}
+		return count;
+	}
 
-		return (const char*)keycode.data();
+	// the chars in ascending order
+	std::wstring Chars() const
+	{
+		std::wstring chars;
+		chars.reserve(Count());
+		for (std::size_t w = 0; w < bits.size(); w++) {
+			for (auto b = bits[w]; b != 0; b &= b - 1) {
+				chars += (wchar_t)((w << 6) | std::countr_zero(b));
+			}
+		}
+		return chars;
 	}
 
-	std::unordered_set<std::string> jp_map;
-	std::array<uint8_t, 3> keycode;
+	// scan(i, chars) for every i in [0, count) on the thread pool, each into a set of its own, ORed together at the end.
+	template<typename F>
+	static CharSet Collect(std::size_t count, F scan)
+	{
+		CharSet chars;
+		std::mutex mutex;
+		ThreadPool::Shared().ParallelFor(count, [&](std::size_t i) {
+			CharSet scanned;
+			scan(i, scanned);
+			std::lock_guard<std::mutex> lock(mutex);
+			chars |= scanned;
+		});
+		return chars;
+	}
+
+private:
+	std::array<uint64_t, 0x10000 / 64> bits{};
+};
+
+class SjisGlyphTable
+{
+public:
+	// utf-16 code unit -> sjis bytes, double-byte codes are stored as (lead << 8) | trail.
+	static constexpr uint16_t Unmapped = 0xFFFF;
+
+	SjisGlyphTable() : table(0x10000, Unmapped) {}
+
+	void Build()
+	{
+		for (std::size_t i = 0; i < table.size(); i++) {
+			table[i] = sjis::from_unicode((char32_t)i);
+		}
+	}
+
+	void Remap(wchar_t ch, const std::string& sjis)
+	{
+		if (sjis.empty() || (std::size_t)ch > 0xFFFF) {
+			return;
+		}
+		table[(std::size_t)ch] = sjis.length() == 1 ? (uint8_t)sjis[0] : (uint16_t)(((uint8_t)sjis[0] << 8) | (uint8_t)sjis[1]);
+	}
+
+	// writes the whole text or nothing, like wcs_to_mbs(src, "").
+	bool Transcode(std::wstring_view src, std::string& dst) const
+	{
+		dst.resize(src.length() * 2);
+		auto out = dst.data();
+		for (auto ch : src) {
+			if (ch == 0) {
+				break;
+			}
+			auto code = (std::size_t)ch <= 0xFFFF ? table[(std::size_t)ch] : Unmapped;
+			if (code == Unmapped) {
+				dst.clear();
+				return false;
+			}
+			if (code > 0xFF) {
+				*out++ = (char)(code >> 8);
+			}
+			*out++ = (char)code;
+		}
+		dst.resize(out - dst.data());
+		return true;
+	}
+
+private:
+	std::vector<uint16_t> table;
 };
 
 struct SirSet
@@ -52,15 +212,82 @@ struct SirSet
 	std::vector<std::shared_ptr<SirCredit>> credits;
 	std::vector<std::shared_ptr<SirRoom>> rooms;
 
+	// ids, type tags, keys and speaker names of every set live in one pool, so org and patch nodes compare by address.
+	static StringPool<char>& Strings() { return SirString::Pool(); }
+
+	// moves the nodes of other to the back of this set.
+	void Append(SirSet&& other)
+	{
+		auto func_append = [](auto& dst, auto& src) {
+			dst.insert(dst.end(), std::make_move_iterator(src.begin()), std::make_move_iterator(src.end()));
+			src.clear();
+		};
+		func_append(dlgs, other.dlgs);
+		func_append(names, other.names);
+		func_append(maps, other.maps);
+		func_append(fonts, other.fonts);
+		func_append(items, other.items);
+		func_append(msgs, other.msgs);
+		func_append(descs, other.descs);
+		func_append(fcharts, other.fcharts);
+		func_append(docs, other.docs);
+		func_append(credits, other.credits);
+		func_append(rooms, other.rooms);
+	}
+
 	std::string GetCountInfo() const
 	{
 		char buffer[256] = { 0, };
-		sprintf_s(buffer,"%llu Dlgs, %llu Names, %llu Fonts, %llu Items, %llu Msgs, %llu Descs, %llu FCharts, %llu Docs, %llu Maps, %llu Credits, %llu Rooms",
+		std::snprintf(buffer, sizeof(buffer), "%zu Dlgs, %zu Names, %zu Fonts, %zu Items, %zu Msgs, %zu Descs, %zu FCharts, %zu Docs, %zu Maps, %zu Credits, %zu Rooms",
 			dlgs.size(), names.size(), fonts.size(), items.size(), msgs.size(), descs.size(), fcharts.size(), docs.size(), maps.size(), credits.size(), rooms.size());
 		return buffer;
 	}
 };
 
+struct PatchManifest
+{
+	static constexpr char FileName[] = "sir-patch.manifest";
+
+	uint64_t glyph_hash = 0;
+	std::map<std::string, uint64_t> entries; // output sir filename -> hash of its inputs
+
+	bool IsUpToDate(const std::string& filename, uint64_t hash) const
+	{
+		auto it = entries.find(filename);
+		return it != entries.end() && it->second == hash;
+	}
+
+	bool Read(const fs::path& file_path)
+	{
+		std::ifstream ifs(file_path);
+		if (!ifs) {
+			return false;
+		}
+
+		std::string key;
+		std::string value;
+		while (ifs >> key >> value) {
+			auto hash = std::strtoull(value.c_str(), nullptr, 16);
+			if (key == "*glyphs") {
+				glyph_hash = hash;
+			}
+			else {
+				entries[key] = hash;
+			}
+		}
+		return true;
+	}
+
+	bool Write(const fs::path& file_path) const
+	{
+		std::ofstream ofs(file_path);
+		ofs << "*glyphs " << ValueToHexString(glyph_hash, false) << "\n";
+		for (auto& e : entries) {
+			ofs << e.first << " " << ValueToHexString(e.second, false) << "\n";
+		}
+		return !ofs.bad();
+	}
+};
 
 class SirTool {
 public:
@@ -71,20 +298,30 @@ public:
 	bool ExePatch(const fs::path& org_dir_path, const fs::path& patch_dir_path, const fs::path& exe_file_path, const fs::path& dst_dir_path);
 	bool GeneratePatchFontChars(const fs::path& org_dir_path, const fs::path& patch_dir_path, const fs::path& dst_file_path);
 	bool GeneratePatchFontData(const fs::path& org_dir_path, const fs::path& patch_dir_path, const fs::path& bmf_default_path, const fs::path& bmf_border_path, const fs::path& dst_dir_path);
+	bool PackStore(const fs::path& xml_dir_path, const fs::path& store_path);
+	bool UnpackStore(const fs::path& store_path, const fs::path& dst_dir_path);
 
 	//private:
-	void RetrievePatchChars(wchar_t scope_min, wchar_t scope_max, std::set<wchar_t>& w_keycodes);
-	void RetrieveExPatchChars(const fs::path& patch_dir_path, wchar_t scope_min, wchar_t scope_max, std::set<wchar_t>& w_keycodes);
-	void RetrievePatchChars(const std::wstring& text, wchar_t scope_min, wchar_t scope_max, std::set<wchar_t>& w_keycodes);
+	void RetrievePatchChars(wchar_t scope_min, wchar_t scope_max, CharSet& w_keycodes);
+	void RetrieveExPatchChars(const fs::path& patch_dir_path, wchar_t scope_min, wchar_t scope_max, CharSet& w_keycodes);
+	void RetrievePatchChars(const std::wstring& text, wchar_t scope_min, wchar_t scope_max, CharSet& w_keycodes);
 
 	std::string PatchText(const std::wstring& text);
 
 	void ReadExePatchFile(const fs::path& file_path, std::map<std::string, std::string>& map);
-	void RetriveAnsiChars(std::set<uint8_t>& ansi_map);
+	void RetriveAnsiChars(CharSet& ansi_map);
 
 	void ReadSirDir(const fs::path& dir_path);
 	bool ReadSirFile(const fs::path& file_path);
+	bool ReadSirFile(const fs::path& file_path, SirSet& set);
+	void ReadSirFiles(const std::vector<fs::path>& file_paths, SirSet& set);
 	void ReadXml(const fs::path& file_path, SirSet& set);
+	void ReadXmls(const std::vector<fs::path>& file_paths, SirSet& set);
+	void ReadStoreFile(const SirStore::FileRef& file, SirSet& set);
+	void ReadStore(const SirStore& store, SirSet& set);
+	// patch_path is a patch directory or a translation store, PatchDir gives the directory holding the fonts and the exe patch.
+	bool ReadPatchTexts(const fs::path& patch_path, SirSet& set);
+	static fs::path PatchDir(const fs::path& patch_path);
 
 	template<typename T>
 	T* FindSirPtr(const std::vector<std::shared_ptr<T>>& container, std::string_view filename)
@@ -98,8 +335,14 @@ public:
 	}
 
 	//private:
+	std::size_t unchanged_count = 0;
+	std::size_t exe_replaced_count = 0;
+	std::size_t exe_unmatched_count = 0;
+	std::size_t exe_duplicated_count = 0;
+	std::size_t stored_count = 0;
+
 	SirSet org_set;
 	SirSet patch_set;
 
-	std::unordered_map<wchar_t, wchar_t> patch_glyphs;
+	SjisGlyphTable patch_glyphs;
 };
\ No newline at end of file
@@ -1,6 +1,6 @@
 #include "SirWriter.hpp"
 
-void SirWriter::Write(const SirDlg& sir, fs::path file_path)
+bool SirWriter::Write(const SirDlg& sir, fs::path file_path)
 {
 	std::vector<uint64_t> offsets;
 	offsets.reserve(sir.nodes.size() * 4);
@@ -82,9 +82,10 @@ void SirWriter::Write(const SirDlg& sir, fs::path file_path)
 
 	std::ofstream ofs(file_path, std::ios::binary);
 	ofs.write(buffer.data(), buffer.size());
+	return (bool)ofs;
 }
 
-void SirWriter::Write(const SirName& sir, fs::path file_path)
+bool SirWriter::Write(const SirName& sir, fs::path file_path)
 {
 	std::vector<uint64_t> offsets;
 	offsets.reserve(sir.nodes.size() * 4);
@@ -172,9 +173,10 @@ void SirWriter::Write(const SirName& sir, fs::path file_path)
 
 	std::ofstream ofs(file_path, std::ios::binary);
 	ofs.write(buffer.data(), buffer.size());
+	return (bool)ofs;
 }
 
-void SirWriter::Write(const SirFont& sir, fs::path file_path)
+bool SirWriter::Write(const SirFont& sir, fs::path file_path)
 {
 	std::vector<uint32_t> footer_font_values;
 	uint64_t node_size = 0;
@@ -225,8 +227,10 @@ void SirWriter::Write(const SirFont& sir, fs::path file_path)
 		*curr_pos = n->hsize[0]; curr_pos += 1;
 		*curr_pos = n->wsize[1]; curr_pos += 1;
 		*curr_pos = n->hsize[1]; curr_pos += 1;
-		memcpy(curr_pos, &n->data[0][0], n->data[0].size()); curr_pos += n->data[0].size();
-		memcpy(curr_pos, &n->data[1][0], n->data[1].size()); curr_pos += n->data[1].size();
+		for (int i = 0; i < 2; i++) {
+			auto src = sir.Pixels(*n, i);
+			memcpy(curr_pos, src.data(), src.size()); curr_pos += src.size();
+		}
 		memset(curr_pos, 0xAA, n->Padding()); curr_pos += n->Padding();
 	}
 
@@ -243,9 +247,10 @@ void SirWriter::Write(const SirFont& sir, fs::path file_path)
 
 	std::ofstream ofs(file_path, std::ios::binary);
 	ofs.write(buffer.data(), buffer.size());
+	return (bool)ofs;
 }
 
-void SirWriter::Write(const SirItem& sir, fs::path file_path)
+bool SirWriter::Write(const SirItem& sir, fs::path file_path)
 {
 	uint64_t node_count = sir.nodes.size();
 	uint64_t data_size = 0;
@@ -352,9 +357,10 @@ void SirWriter::Write(const SirItem& sir, fs::path file_path)
 
 	std::ofstream ofs(file_path, std::ios::binary);
 	ofs.write(buffer.data(), buffer.size());
+	return (bool)ofs;
 }
 
-void SirWriter::Write(const SirMsg& sir, fs::path file_path)
+bool SirWriter::Write(const SirMsg& sir, fs::path file_path)
 {
 	uint64_t node_count = sir.nodes.size();
 	uint64_t data_size = 0;
@@ -454,9 +460,10 @@ void SirWriter::Write(const SirMsg& sir, fs::path file_path)
 
 	std::ofstream ofs(file_path, std::ios::binary);
 	ofs.write(buffer.data(), buffer.size());
+	return (bool)ofs;
 }
 
-void SirWriter::Write(const SirDesc& sir, fs::path file_path)
+bool SirWriter::Write(const SirDesc& sir, fs::path file_path)
 {
 	uint64_t node_count = sir.nodes.size();
 	uint64_t text_count = sir.texts.size();
@@ -668,14 +675,15 @@ void SirWriter::Write(const SirDesc& sir, fs::path file_path)
 
 	if (writer.pos - start_pos > buffer_size)
 	{
-		throw new std::exception("!alloc");
+		throw std::runtime_error("!alloc");
 	}
 
 	std::ofstream ofs(file_path, std::ios::binary);
 	ofs.write(buffer.data(), buffer.size());
+	return (bool)ofs;
 }
 
-void SirWriter::Write(const SirFChart& sir, fs::path file_path)
+bool SirWriter::Write(const SirFChart& sir, fs::path file_path)
 {
 	uint64_t node_count = sir.nodes.size();
 	uint64_t data_size = 0;
@@ -811,9 +819,10 @@ void SirWriter::Write(const SirFChart& sir, fs::path file_path)
 
 	std::ofstream ofs(file_path, std::ios::binary);
 	ofs.write(buffer.data(), buffer.size());
+	return (bool)ofs;
 }
 
-void SirWriter::Write(const SirDoc& sir, fs::path file_path)
+bool SirWriter::Write(const SirDoc& sir, fs::path file_path)
 {
 	uint64_t node_count = sir.nodes.size();
 	uint64_t data_size = 0;
@@ -923,9 +932,10 @@ void SirWriter::Write(const SirDoc& sir, fs::path file_path)
 
 	std::ofstream ofs(file_path, std::ios::binary);
 	ofs.write(buffer.data(), buffer.size());
+	return (bool)ofs;
 }
 
-void SirWriter::Write(const SirMap& sir, fs::path file_path)
+bool SirWriter::Write(const SirMap& sir, fs::path file_path)
 {
 	uint64_t node_count = sir.nodes.size();
 	uint64_t item_count = 0;
@@ -1037,9 +1047,10 @@ void SirWriter::Write(const SirMap& sir, fs::path file_path)
 
 	std::ofstream ofs(file_path, std::ios::binary);
 	ofs.write(buffer.data(), buffer.size());
+	return (bool)ofs;
 }
 
-void SirWriter::Write(const SirCredit& sir, fs::path file_path)
+bool SirWriter::Write(const SirCredit& sir, fs::path file_path)
 {
 	uint64_t node_count = sir.nodes.size();
 	uint64_t item_count = 0;
@@ -1143,9 +1154,10 @@ void SirWriter::Write(const SirCredit& sir, fs::path file_path)
 
 	std::ofstream ofs(file_path, std::ios::binary);
 	ofs.write(buffer.data(), buffer.size());
+	return (bool)ofs;
 }
 
-void SirWriter::Write(const SirRoom& sir, fs::path file_path)
+bool SirWriter::Write(const SirRoom& sir, fs::path file_path)
 {
 	uint64_t node_count = sir.nodes.size();
 	uint64_t item_count = 0;
@@ -1259,4 +1271,5 @@ void SirWriter::Write(const SirRoom& sir, fs::path file_path)
 
 	std::ofstream ofs(file_path, std::ios::binary);
 	ofs.write(buffer.data(), buffer.size());
+	return (bool)ofs;
 }
\ No newline at end of file
@@ -1,33 +1,52 @@
 #pragma once
 
 #include "Sir.hpp"
+#include "ThreadPool.hpp"
 
 class SirWriter {
 public:
+	// written is cleared when a file can't be written.
 	template <typename T>
-	static void WriteAll(std::vector<std::shared_ptr<T>>& sirs, const fs::path& dst_dir_path)
+	static void AddWrites(const std::vector<std::shared_ptr<T>>& sirs, const fs::path& dst_dir_path, ThreadPool::Tasks& tasks, std::atomic_bool& written)
 	{
-		for (auto sir : sirs) {
-			Write(*sir, fs::path(dst_dir_path).append(sir->filename + ".sir"));
+		for (auto& sir : sirs) {
+			tasks.push_back([sir = sir.get(), dst_dir_path, &written]() {
+				if (!Write(*sir, fs::path(dst_dir_path).append(sir->filename + ".sir"))) {
+					written = false;
+				}
+			});
 		}
 	}
 	template <typename T>
-	static void WriteAll(std::vector<T*>& sirs, const fs::path& dst_dir_path)
+	static void AddWrites(const std::vector<T*>& sirs, const fs::path& dst_dir_path, ThreadPool::Tasks& tasks, std::atomic_bool& written)
 	{
 		for (auto sir : sirs) {
-			Write(*sir, fs::path(dst_dir_path).append(sir->filename + ".sir"));
+			tasks.push_back([sir, dst_dir_path, &written]() {
+				if (!Write(*sir, fs::path(dst_dir_path).append(sir->filename + ".sir"))) {
+					written = false;
+				}
+			});
 		}
 	}
+	template <typename T>
+	static bool WriteAll(std::vector<T>& sirs, const fs::path& dst_dir_path)
+	{
+		std::atomic_bool written = true;
+		ThreadPool::Tasks tasks;
+		AddWrites(sirs, dst_dir_path, tasks, written);
+		ThreadPool::Shared().RunAll(tasks);
+		return written;
+	}
 
-	static void Write(const SirDlg& sir, fs::path file_path);
-	static void Write(const SirName& sir, fs::path file_path);
-	static void Write(const SirFont& sir, fs::path file_path);
-	static void Write(const SirItem& sir, fs::path file_path);
-	static void Write(const SirMsg& sir, fs::path file_path);
-	static void Write(const SirDesc& sir, fs::path file_path);
-	static void Write(const SirFChart& sir, fs::path file_path);
-	static void Write(const SirDoc& sir, fs::path file_path);
-	static void Write(const SirMap& sir, fs::path file_path);
-	static void Write(const SirCredit& sir, fs::path file_path);
-	static void Write(const SirRoom& sir, fs::path file_path);
+	static bool Write(const SirDlg& sir, fs::path file_path);
+	static bool Write(const SirName& sir, fs::path file_path);
+	static bool Write(const SirFont& sir, fs::path file_path);
+	static bool Write(const SirItem& sir, fs::path file_path);
+	static bool Write(const SirMsg& sir, fs::path file_path);
+	static bool Write(const SirDesc& sir, fs::path file_path);
+	static bool Write(const SirFChart& sir, fs::path file_path);
+	static bool Write(const SirDoc& sir, fs::path file_path);
+	static bool Write(const SirMap& sir, fs::path file_path);
+	static bool Write(const SirCredit& sir, fs::path file_path);
+	static bool Write(const SirRoom& sir, fs::path file_path);
 };
\ No newline at end of file
@@ -1,35 +1,76 @@
 #include "SirXmlReader.hpp"
 
-std::shared_ptr<SirDlg> SirXmlReader::ReadDlg(fs::path file_path)
+// attribute text as written in the file, entities translated.
+template<typename A>
+static std::string_view RawValue(const A& attr)
 {
-	auto sir = std::make_shared<SirDlg>();
-	sir->filename = file_path.stem().stem().string();
-	
+	thread_local std::string scratch;
+	return XmlValue(attr, scratch);
+}
 
-	rapidxml::file<char> xmlFile(file_path.string().c_str()); // Default template is char
-	rapidxml::xml_document<char> doc;
-	doc.parse<0>(xmlFile.data());
+// attribute text converted to sjis, the utf-8 bytes as is when it doesn't convert (same as utf8_to_mbs).
+template<typename A>
+static std::string_view SjisValue(const A& attr)
+{
+	thread_local std::string scratch;
+	thread_local std::string sjis_text;
+	auto value = XmlValue(attr, scratch);
+	if (sjis::from_utf8(value, sjis_text) != sjis::error::none) {
+		return value;
+	}
+	return sjis_text;
+}
+
+// the wide patch text and its sjis form, both decoded from the utf-8 text. the sjis form is empty when it doesn't convert.
+template<typename A, typename W, typename S>
+static void ReadPatchText(const A& attr, W& patch_text, S& text)
+{
+	thread_local std::string scratch;
+	thread_local std::wstring wide_text;
+	thread_local std::string sjis_text;
+	auto value = XmlValue(attr, scratch);
+	if constexpr (std::is_same_v<W, std::wstring>) {
+		utf8_to_wcs(value, patch_text);
+	}
+	else {
+		utf8_to_wcs(value, wide_text);
+		patch_text = wide_text;
+	}
+	if constexpr (std::is_same_v<S, std::string>) {
+		sjis::from_utf8(value, text);
+	}
+	else {
+		sjis::from_utf8(value, sjis_text);
+		text = sjis_text;
+	}
+}
+
+template<typename N>
+static std::shared_ptr<SirDlg> ReadDlgXml(std::string filename, N node_sir)
+{
+	auto sir = std::make_shared<SirDlg>();
+	sir->filename = std::move(filename);
 
-	auto node_sir = doc.first_node();
 	auto node_dlgs = node_sir->first_node();
 	auto node_dlg = node_dlgs->first_node();
 	while (node_dlg != nullptr) {
 		auto n = std::make_shared<SirDlg::Node>();
 		auto attr_dlg = node_dlg->first_attribute();
+		static constexpr XmlNameTable dlg_attrs({ "id", "type", "name", "text" });
 		while (attr_dlg != nullptr) {
-			if (strcmp(attr_dlg->name(), "id") == 0) {
-				n->id__ = attr_dlg->value();
-			}
-			else if (strcmp(attr_dlg->name(), "type") == 0) {
-				n->type = attr_dlg->value();
-			}
-			else if (strcmp(attr_dlg->name(), "name") == 0) {
-				n->patch_name = utf8_to_wcs(attr_dlg->value());
-				n->name = wcs_to_mbs(n->patch_name, "");
-			}
-			else if (strcmp(attr_dlg->name(), "text") == 0) {
-				n->patch_text = utf8_to_wcs(attr_dlg->value());
-				n->text = wcs_to_mbs(n->patch_text, "");
+			switch (dlg_attrs.Find(XmlName(attr_dlg))) {
+			case dlg_attrs.Index("id"):
+				n->id__ = RawValue(attr_dlg);
+				break;
+			case dlg_attrs.Index("type"):
+				n->type = RawValue(attr_dlg);
+				break;
+			case dlg_attrs.Index("name"):
+				ReadPatchText(attr_dlg, n->patch_name, n->name);
+				break;
+			case dlg_attrs.Index("text"):
+				ReadPatchText(attr_dlg, n->patch_text, n->text);
+				break;
 			}
 
 			attr_dlg = attr_dlg->next_attribute();
@@ -42,41 +83,49 @@ std::shared_ptr<SirDlg> SirXmlReader::ReadDlg(fs::path file_path)
 	return sir;
 }
 
-std::shared_ptr<SirName> SirXmlReader::ReadName(fs::path file_path)
+std::shared_ptr<SirDlg> SirXmlReader::ReadDlg(fs::path file_path)
 {
-	auto sir = std::make_shared<SirName>();
-	sir->filename = file_path.stem().stem().string();
-	
+	XmlFile doc(file_path);
+	return ReadDlgXml(file_path.stem().stem().string(), doc.first_node());
+}
 
-	rapidxml::file<char> xmlFile(file_path.string().c_str()); // Default template is char
-	rapidxml::xml_document<char> doc;
-	doc.parse<0>(xmlFile.data());
+std::shared_ptr<SirDlg> SirXmlReader::ReadDlg(const SirStore::FileRef& file)
+{
+	return ReadDlgXml(file.Stem(), file.Root());
+}
+
+template<typename N>
+static std::shared_ptr<SirName> ReadNameXml(std::string filename, N node_sir)
+{
+	auto sir = std::make_shared<SirName>();
+	sir->filename = std::move(filename);
 
-	auto node_sir = doc.first_node();
 	auto node_dlgs = node_sir->first_node();
 	auto node_dlg = node_dlgs->first_node();
 	while (node_dlg != nullptr) {
 		auto n = std::make_shared<SirName::Node>();
 		auto attr_dlg = node_dlg->first_attribute();
+		static constexpr XmlNameTable dlg_attrs({ "key", "name", "kye2", "msg", "unknown1", "unknown2" });
 		while (attr_dlg != nullptr) {
-			if (strcmp(attr_dlg->name(), "key") == 0) {
-				n->key_name = utf8_to_mbs(attr_dlg->value());
-			}
-			else if (strcmp(attr_dlg->name(), "name") == 0) {
-				n->patch_name = utf8_to_wcs(attr_dlg->value());
-				n->name = wcs_to_mbs(n->patch_name, "");
-			}
-			else if (strcmp(attr_dlg->name(), "kye2") == 0) {
-				n->key_msg = utf8_to_mbs(attr_dlg->value());
-			}
-			else if (strcmp(attr_dlg->name(), "msg") == 0) {
-				n->msg = utf8_to_mbs(attr_dlg->value());
-			}
-			else if (strcmp(attr_dlg->name(), "unknown1") == 0) {
+			switch (dlg_attrs.Find(XmlName(attr_dlg))) {
+			case dlg_attrs.Index("key"):
+				n->key_name = SjisValue(attr_dlg);
+				break;
+			case dlg_attrs.Index("name"):
+				ReadPatchText(attr_dlg, n->patch_name, n->name);
+				break;
+			case dlg_attrs.Index("kye2"):
+				n->key_msg = SjisValue(attr_dlg);
+				break;
+			case dlg_attrs.Index("msg"):
+				n->msg = SjisValue(attr_dlg);
+				break;
+			case dlg_attrs.Index("unknown1"):
 				n->unknown_value[0] = atoi(attr_dlg->value());
-			}
-			else if (strcmp(attr_dlg->name(), "unknown2") == 0) {
+				break;
+			case dlg_attrs.Index("unknown2"):
 				n->unknown_value[1] = atoi(attr_dlg->value());
+				break;
 			}
 
 			attr_dlg = attr_dlg->next_attribute();
@@ -89,19 +138,33 @@ std::shared_ptr<SirName> SirXmlReader::ReadName(fs::path file_path)
 	return sir;
 }
 
+std::shared_ptr<SirName> SirXmlReader::ReadName(fs::path file_path)
+{
+	XmlFile doc(file_path);
+	return ReadNameXml(file_path.stem().stem().string(), doc.first_node());
+}
+
+std::shared_ptr<SirName> SirXmlReader::ReadName(const SirStore::FileRef& file)
+{
+	return ReadNameXml(file.Stem(), file.Root());
+}
+
 std::shared_ptr<SirFont> SirXmlReader::ReadFont(fs::path xmlfile_path, fs::path default_png_file_path, fs::path border_png_file_path)
 {
 	auto sir = std::make_shared<SirFont>();
 	sir->filename = xmlfile_path.stem().stem().string();
 	
 
-	std::vector<uint8_t> png_buffers[2];
-	PngReader::Read(default_png_file_path, png_buffers[0]);
-	PngReader::Read(border_png_file_path, png_buffers[1]);
+	// kept per thread, the next font decodes into the same memory.
+	thread_local std::vector<uint8_t> png_buffers[2];
+	std::array<uint32_t, 2> decoded_width{};
+	std::array<uint32_t, 2> decoded_height{};
+	if (!PngReader::Read(default_png_file_path, decoded_width[0], decoded_height[0], png_buffers[0]) ||
+		!PngReader::Read(border_png_file_path, decoded_width[1], decoded_height[1], png_buffers[1])) {
+		throw std::runtime_error("invalid png file");
+	}
 
-	rapidxml::file<char> xmlFile(xmlfile_path.string().c_str()); // Default template is char
-	rapidxml::xml_document<char> doc;
-	doc.parse<0>(xmlFile.data());
+	XmlFile doc(xmlfile_path);
 
 	auto node_sir = doc.first_node();
 	auto node_png = node_sir->first_node();
@@ -114,15 +177,33 @@ std::shared_ptr<SirFont> SirXmlReader::ReadFont(fs::path xmlfile_path, fs::path
 	for (int i = 0; i < 2; i++)
 	{
 		auto attr_png = node_png->first_attribute();
+		static constexpr XmlNameTable png_attrs({ "png_width", "png_height", "font_width", "font_height", "font_wcount", "font_hcount" });
 		while (attr_png != nullptr) {
-			if (false) {}
-			M_RAPID_XML_ATTR_IF_SET_INT(attr_png, "png_width", png_width[i])
-				M_RAPID_XML_ATTR_IF_SET_INT(attr_png, "png_height", png_height[i])
-				M_RAPID_XML_ATTR_IF_SET_INT(attr_png, "font_width", font_width[i])
-				M_RAPID_XML_ATTR_IF_SET_INT(attr_png, "font_height", font_height[i])
-				M_RAPID_XML_ATTR_IF_SET_INT(attr_png, "font_wcount", wcount[i])
-				M_RAPID_XML_ATTR_IF_SET_INT(attr_png, "font_hcount", hcount[i])
-				attr_png = attr_png->next_attribute();
+			switch (png_attrs.Find(XmlName(attr_png))) {
+			case png_attrs.Index("png_width"):
+				png_width[i] = atoi(attr_png->value());
+				break;
+			case png_attrs.Index("png_height"):
+				png_height[i] = atoi(attr_png->value());
+				break;
+			case png_attrs.Index("font_width"):
+				font_width[i] = atoi(attr_png->value());
+				break;
+			case png_attrs.Index("font_height"):
+				font_height[i] = atoi(attr_png->value());
+				break;
+			case png_attrs.Index("font_wcount"):
+				wcount[i] = atoi(attr_png->value());
+				break;
+			case png_attrs.Index("font_hcount"):
+				hcount[i] = atoi(attr_png->value());
+				break;
+			}
+			attr_png = attr_png->next_attribute();
+		}
+
+		if (png_width[i] != decoded_width[i] || png_height[i] != decoded_height[i]) {
+			throw std::runtime_error("png size doesn't match the font xml");
 		}
 
 		node_png = node_png->next_sibling();;
@@ -131,23 +212,37 @@ std::shared_ptr<SirFont> SirXmlReader::ReadFont(fs::path xmlfile_path, fs::path
 	auto node_etc = node_png;
 	{
 		auto attr_etc = node_etc->first_attribute();
+		static constexpr XmlNameTable etc_attrs({ "unknown1", "unknown2" });
 		while (attr_etc != nullptr) {
-			if (false) {}
-			M_RAPID_XML_ATTR_IF_SET_INT(attr_etc, "unknown1", sir->footer_unknown_values[0])
-				M_RAPID_XML_ATTR_IF_SET_INT(attr_etc, "unknown2", sir->footer_unknown_values[1])
-				attr_etc = attr_etc->next_attribute();
+			switch (etc_attrs.Find(XmlName(attr_etc))) {
+			case etc_attrs.Index("unknown1"):
+				sir->footer_unknown_values[0] = atoi(attr_etc->value());
+				break;
+			case etc_attrs.Index("unknown2"):
+				sir->footer_unknown_values[1] = atoi(attr_etc->value());
+				break;
+			}
+			attr_etc = attr_etc->next_attribute();
 		}
 	}
 
 	auto node_fonts = node_etc->next_sibling();
 	auto node_font = node_fonts->first_node();
 	int inode = 0;
+	// glyphs packed to the same spot of a page are read once and share their pixels, like SirFont::SharePixels leaves them.
+	std::array<std::unordered_map<uint64_t, uint32_t>, 2> read_offsets; // x, y, w, h -> offset in the arena
 	while (node_font != nullptr) {
 		auto n = std::make_shared<SirFont::Node>();
+		// packed pages give every glyph its position, grid pages leave it to the cell of the node.
+		std::array<std::optional<uint32_t>, 2> png_xpos;
+		std::array<std::optional<uint32_t>, 2> png_ypos;
 		auto attr_font = node_font->first_attribute();
+		static constexpr XmlNameTable font_attrs({ "bin", "ch", "default_w", "default_h", "default_x", "default_y",
+			"border_w", "border_h", "border_x", "border_y" });
 		while (attr_font != nullptr) {
-			if (strcmp(attr_font->name(), "bin") == 0) {
-				auto hex_bytes = HexStringToBytes(attr_font->value());
+			switch (font_attrs.Find(XmlName(attr_font))) {
+			case font_attrs.Index("bin"): {
+				auto hex_bytes = HexStringToBytes(std::string(RawValue(attr_font)));
 				hex_bytes.resize(2);
 				if (hex_bytes[1] == 0) {
 					n->keycode[0] = hex_bytes[0];
@@ -156,34 +251,57 @@ std::shared_ptr<SirFont> SirXmlReader::ReadFont(fs::path xmlfile_path, fs::path
 					n->keycode[0] = hex_bytes[1];
 					n->keycode[1] = hex_bytes[0];
 				}
+				break;
 			}
-			else if (strcmp(attr_font->name(), "ch") == 0) {
-				n->patch_keycode = attr_font->value();
-			}
-			else if (strcmp(attr_font->name(), "default_w") == 0) {
+			case font_attrs.Index("ch"):
+				n->patch_keycode = RawValue(attr_font);
+				break;
+			case font_attrs.Index("default_w"):
 				n->wsize[0] = atoi(attr_font->value());
-			}
-			else if (strcmp(attr_font->name(), "default_h") == 0) {
+				break;
+			case font_attrs.Index("default_h"):
 				n->hsize[0] = atoi(attr_font->value());
-			}
-			else if (strcmp(attr_font->name(), "border_w") == 0) {
+				break;
+			case font_attrs.Index("default_x"):
+				png_xpos[0] = atoi(attr_font->value());
+				break;
+			case font_attrs.Index("default_y"):
+				png_ypos[0] = atoi(attr_font->value());
+				break;
+			case font_attrs.Index("border_w"):
 				n->wsize[1] = atoi(attr_font->value());
-			}
-			else if (strcmp(attr_font->name(), "border_h") == 0) {
+				break;
+			case font_attrs.Index("border_h"):
 				n->hsize[1] = atoi(attr_font->value());
+				break;
+			case font_attrs.Index("border_x"):
+				png_xpos[1] = atoi(attr_font->value());
+				break;
+			case font_attrs.Index("border_y"):
+				png_ypos[1] = atoi(attr_font->value());
+				break;
 			}
 			attr_font = attr_font->next_attribute();
 		}
 		for (int i = 0; i < 2; i++) {
-			auto png_xpos = (inode % wcount[i]) * font_width[i];
-			auto png_ypos = (inode / wcount[i]) * font_height[i];
-
-			auto data_size = n->wsize[i] * n->hsize[i];
-			n->data[i].resize(data_size);
-			for (int y = 0; y < n->hsize[i]; y++) {
-				for (int x = 0; x < n->wsize[i]; x++) {
-					n->data[i][y * n->wsize[i] + x] = png_buffers[i][(png_ypos + y) * png_width[i] + png_xpos + x];
-				}
+			if ((!png_xpos[i] || !png_ypos[i]) && wcount[i] == 0) {
+				throw std::runtime_error("font glyph without a position");
+			}
+			auto x = png_xpos[i] ? *png_xpos[i] : (inode % wcount[i]) * font_width[i];
+			auto y = png_ypos[i] ? *png_ypos[i] : (inode / wcount[i]) * font_height[i];
+			if ((uint64_t)x + n->wsize[i] > png_width[i] || (uint64_t)y + n->hsize[i] > png_height[i]) {
+				throw std::runtime_error("font glyph outside of its png");
+			}
+
+			auto key = ((uint64_t)x << 40) | ((uint64_t)y << 16) | (n->wsize[i] << 8) | n->hsize[i];
+			auto [it, inserted] = read_offsets[i].try_emplace(key, (uint32_t)sir->pixels[i].size());
+			if (!inserted) {
+				n->offset[i] = it->second;
+				continue;
+			}
+			auto dst = sir->AllocPixels(*n, i).data();
+			for (int row = 0; row < n->hsize[i]; row++) {
+				memcpy(dst + row * n->wsize[i], png_buffers[i].data() + (y + row) * png_width[i] + x, n->wsize[i]);
 			}
 		}
 
@@ -195,25 +313,20 @@ std::shared_ptr<SirFont> SirXmlReader::ReadFont(fs::path xmlfile_path, fs::path
 	return sir;
 }
 
-std::shared_ptr<SirItem> SirXmlReader::ReadItem(fs::path file_path)
+template<typename N>
+static std::shared_ptr<SirItem> ReadItemXml(std::string filename, N node_sir)
 {
 	auto sir = std::make_shared<SirItem>();
-	sir->filename = file_path.stem().stem().string();
-	
-
-	rapidxml::file<char> xmlFile(file_path.string().c_str()); // Default template is char
-	rapidxml::xml_document<char> doc;
-	doc.parse<0>(xmlFile.data());
+	sir->filename = std::move(filename);
 
-	auto node_sir = doc.first_node();
 	auto node_nodes = node_sir->first_node();
 	auto node_node = node_nodes->first_node();
 	while (node_node != nullptr) {
 		auto n = std::make_shared<SirItem::Node>();
 		auto attr_node = node_node->first_attribute();
 		while (attr_node != nullptr) {
-			if (strcmp(attr_node->name(), "name") == 0) {
-				n->name = utf8_to_mbs(attr_node->value());
+			if (XmlName(attr_node) == "name") {
+				n->name = SjisValue(attr_node);
 			}
 			attr_node = attr_node->next_attribute();
 		}
@@ -223,28 +336,30 @@ std::shared_ptr<SirItem> SirXmlReader::ReadItem(fs::path file_path)
 			auto item = std::make_shared<SirItem::Node::Item>();
 
 			auto attr_item = item_node->first_attribute();
+			static constexpr XmlNameTable item_attrs({ "key", "text1", "text2", "unknown1", "unknown2", "unknown3", "unknown4" });
 			while (attr_item != nullptr) {
-				if (strcmp(attr_item->name(), "key") == 0) {
-					item->key = "^" + utf8_to_mbs(attr_item->value());
-				}
-				else if (strcmp(attr_item->name(), "text1") == 0) {
-					item->patch_text = utf8_to_wcs(attr_item->value());
-					item->text1 = wcs_to_mbs(item->patch_text, "");
-				}
-				else if (strcmp(attr_item->name(), "text2") == 0) {
-					item->text2 = utf8_to_mbs(attr_item->value());
-				}
-				else if (strcmp(attr_item->name(), "unknown1") == 0) {
+				switch (item_attrs.Find(XmlName(attr_item))) {
+				case item_attrs.Index("key"):
+					item->key = "^" + std::string(SjisValue(attr_item));
+					break;
+				case item_attrs.Index("text1"):
+					ReadPatchText(attr_item, item->patch_text, item->text1);
+					break;
+				case item_attrs.Index("text2"):
+					item->text2 = SjisValue(attr_item);
+					break;
+				case item_attrs.Index("unknown1"):
 					item->unknowns[0] = atoi(attr_item->value());
-				}
-				else if (strcmp(attr_item->name(), "unknown2") == 0) {
+					break;
+				case item_attrs.Index("unknown2"):
 					item->unknowns[1] = atoi(attr_item->value());
-				}
-				else if (strcmp(attr_item->name(), "unknown3") == 0) {
+					break;
+				case item_attrs.Index("unknown3"):
 					item->unknowns[2] = atoi(attr_item->value());
-				}
-				else if (strcmp(attr_item->name(), "unknown4") == 0) {
+					break;
+				case item_attrs.Index("unknown4"):
 					item->unknowns[3] = atoi(attr_item->value());
+					break;
 				}
 				attr_item = attr_item->next_attribute();
 			}
@@ -260,21 +375,27 @@ std::shared_ptr<SirItem> SirXmlReader::ReadItem(fs::path file_path)
 	return sir;
 }
 
-std::shared_ptr<SirMsg> SirXmlReader::ReadMsg(fs::path file_path)
+std::shared_ptr<SirItem> SirXmlReader::ReadItem(fs::path file_path)
 {
-	auto sir = std::make_shared<SirMsg>();
-	sir->filename = file_path.stem().stem().string();
-	
+	XmlFile doc(file_path);
+	return ReadItemXml(file_path.stem().stem().string(), doc.first_node());
+}
 
-	rapidxml::file<char> xmlFile(file_path.string().c_str()); // Default template is char
-	rapidxml::xml_document<char> doc;
-	doc.parse<0>(xmlFile.data());
+std::shared_ptr<SirItem> SirXmlReader::ReadItem(const SirStore::FileRef& file)
+{
+	return ReadItemXml(file.Stem(), file.Root());
+}
+
+template<typename N>
+static std::shared_ptr<SirMsg> ReadMsgXml(std::string filename, N node_sir)
+{
+	auto sir = std::make_shared<SirMsg>();
+	sir->filename = std::move(filename);
 
-	auto node_sir = doc.first_node();
 	auto node_dlgs = node_sir->first_node();
 	auto attr_dlgs = node_dlgs->first_attribute();
 	while (attr_dlgs != nullptr) {
-		if (strcmp(attr_dlgs->name(), "unknown") == 0) {
+		if (XmlName(attr_dlgs) == "unknown") {
 			sir->unknown = (uint64_t)atoi(attr_dlgs->value());
 		}
 		attr_dlgs = attr_dlgs->next_attribute();
@@ -285,21 +406,24 @@ std::shared_ptr<SirMsg> SirXmlReader::ReadMsg(fs::path file_path)
 	while (node_dlg != nullptr) {
 		auto n = std::make_shared<SirMsg::Node>();
 		auto attr_dlg = node_dlg->first_attribute();
+		static constexpr XmlNameTable dlg_attrs({ "key", "unknown1", "unknown2", "unknown3", "unknown4" });
 		while (attr_dlg != nullptr) {
-			if (strcmp(attr_dlg->name(), "key") == 0) {
-				n->key = attr_dlg->value();
-			}
-			else if (strcmp(attr_dlg->name(), "unknown1") == 0) {
+			switch (dlg_attrs.Find(XmlName(attr_dlg))) {
+			case dlg_attrs.Index("key"):
+				n->key = RawValue(attr_dlg);
+				break;
+			case dlg_attrs.Index("unknown1"):
 				n->unknowns[0] = atoi(attr_dlg->value());
-			}
-			else if (strcmp(attr_dlg->name(), "unknown2") == 0) {
+				break;
+			case dlg_attrs.Index("unknown2"):
 				n->unknowns[1] = atoi(attr_dlg->value());
-			}
-			else if (strcmp(attr_dlg->name(), "unknown3") == 0) {
+				break;
+			case dlg_attrs.Index("unknown3"):
 				n->unknowns[2] = atoi(attr_dlg->value());
-			}
-			else if (strcmp(attr_dlg->name(), "unknown4") == 0) {
+				break;
+			case dlg_attrs.Index("unknown4"):
 				n->unknowns[3] = atoi(attr_dlg->value());
+				break;
 			}
 			attr_dlg = attr_dlg->next_attribute();
 		}
@@ -308,9 +432,8 @@ std::shared_ptr<SirMsg> SirXmlReader::ReadMsg(fs::path file_path)
 		while (node_text != nullptr) {
 			auto attr_text = node_text->first_attribute();
 			while (attr_text != nullptr) {
-				if (strcmp(attr_text->name(), "value") == 0) {
-					n->patch_texts.push_back(utf8_to_wcs(attr_text->value()));
-					n->texts.push_back(wcs_to_mbs(n->patch_texts.back(), ""));
+				if (XmlName(attr_text) == "value") {
+					ReadPatchText(attr_text, n->patch_texts.emplace_back(), n->texts.emplace_back());
 				}
 				attr_text = attr_text->next_attribute();
 			}
@@ -324,22 +447,28 @@ std::shared_ptr<SirMsg> SirXmlReader::ReadMsg(fs::path file_path)
 	return sir;
 }
 
-std::shared_ptr<SirDesc> SirXmlReader::ReadDesc(fs::path file_path)
+std::shared_ptr<SirMsg> SirXmlReader::ReadMsg(fs::path file_path)
 {
-	auto sir = std::make_shared<SirDesc>();
-	sir->filename = file_path.stem().stem().string();
-	
+	XmlFile doc(file_path);
+	return ReadMsgXml(file_path.stem().stem().string(), doc.first_node());
+}
 
-	rapidxml::file<char> xmlFile(file_path.string().c_str()); // Default template is char
-	rapidxml::xml_document<char> doc;
-	doc.parse<0>(xmlFile.data());
+std::shared_ptr<SirMsg> SirXmlReader::ReadMsg(const SirStore::FileRef& file)
+{
+	return ReadMsgXml(file.Stem(), file.Root());
+}
+
+template<typename N>
+static std::shared_ptr<SirDesc> ReadDescXml(std::string filename, N node_sir)
+{
+	auto sir = std::make_shared<SirDesc>();
+	sir->filename = std::move(filename);
 
-	auto node_sir = doc.first_node();
 
 	auto attr_sir = node_sir->first_attribute();
 	while (attr_sir != nullptr) {
-		if (strcmp(attr_sir->name(), "sound") == 0) {
-			sir->sound_file_name = utf8_to_mbs(attr_sir->value());
+		if (XmlName(attr_sir) == "sound") {
+			sir->sound_file_name = SjisValue(attr_sir);
 		}
 		attr_sir = attr_sir->next_attribute();
 	}
@@ -350,12 +479,15 @@ std::shared_ptr<SirDesc> SirXmlReader::ReadDesc(fs::path file_path)
 	while (node_dlg != nullptr) {
 		auto n = std::make_shared<SirDesc::Node>();
 		auto attr_dlg = node_dlg->first_attribute();
+		static constexpr XmlNameTable dlg_attrs({ "id", "byte" });
 		while (attr_dlg != nullptr) {
-			if (strcmp(attr_dlg->name(), "id") == 0) {
-				n->id = utf8_to_mbs(attr_dlg->value());
-			}
-			else if (strcmp(attr_dlg->name(), "byte") == 0) {
-				n->bytes = HexStringToBytes(attr_dlg->value());
+			switch (dlg_attrs.Find(XmlName(attr_dlg))) {
+			case dlg_attrs.Index("id"):
+				n->id = SjisValue(attr_dlg);
+				break;
+			case dlg_attrs.Index("byte"):
+				n->bytes = HexStringToBytes(std::string(RawValue(attr_dlg)));
+				break;
 			}
 			attr_dlg = attr_dlg->next_attribute();
 		}
@@ -369,13 +501,15 @@ std::shared_ptr<SirDesc> SirXmlReader::ReadDesc(fs::path file_path)
 	while (node_text != nullptr) {
 		auto attr_text = node_text->first_attribute();
 		auto t = std::make_shared<SirDesc::Text>();
+		static constexpr XmlNameTable text_attrs({ "id", "value" });
 		while (attr_text != nullptr) {
-			if (strcmp(attr_text->name(), "id") == 0) {
+			switch (text_attrs.Find(XmlName(attr_text))) {
+			case text_attrs.Index("id"):
 				t->temp_id = atoi(attr_text->value());
-			}
-			else if (strcmp(attr_text->name(), "value") == 0) {
-				t->patch_text = utf8_to_wcs(attr_text->value());
-				t->value = wcs_to_mbs(t->patch_text, "");
+				break;
+			case text_attrs.Index("value"):
+				ReadPatchText(attr_text, t->patch_text, t->value);
+				break;
 			}
 			attr_text = attr_text->next_attribute();
 		}
@@ -388,8 +522,8 @@ std::shared_ptr<SirDesc> SirXmlReader::ReadDesc(fs::path file_path)
 	while (node_start != nullptr) {
 		auto attr_start = node_start->first_attribute();
 		while (attr_start != nullptr) {
-			if (strcmp(attr_start->name(), "value") == 0) {
-				sir->starts.push_back(utf8_to_mbs(attr_start->value()));
+			if (XmlName(attr_start) == "value") {
+				sir->starts.emplace_back(SjisValue(attr_start));
 			}
 			attr_start = attr_start->next_attribute();
 		}
@@ -401,8 +535,8 @@ std::shared_ptr<SirDesc> SirXmlReader::ReadDesc(fs::path file_path)
 	while (node_var != nullptr) {
 		auto attr_var = node_var->first_attribute();
 		while (attr_var != nullptr) {
-			if (strcmp(attr_var->name(), "value") == 0) {
-				sir->vars.push_back(utf8_to_mbs(attr_var->value()));
+			if (XmlName(attr_var) == "value") {
+				sir->vars.emplace_back(SjisValue(attr_var));
 			}
 			attr_var = attr_var->next_attribute();
 		}
@@ -412,53 +546,61 @@ std::shared_ptr<SirDesc> SirXmlReader::ReadDesc(fs::path file_path)
 	return sir;
 }
 
-std::shared_ptr<SirFChart> SirXmlReader::ReadFChart(fs::path file_path)
+std::shared_ptr<SirDesc> SirXmlReader::ReadDesc(fs::path file_path)
 {
-	auto sir = std::make_shared<SirFChart>();
-	sir->filename = file_path.stem().stem().string();
-	
+	XmlFile doc(file_path);
+	return ReadDescXml(file_path.stem().stem().string(), doc.first_node());
+}
 
-	rapidxml::file<char> xmlFile(file_path.string().c_str()); // Default template is char
-	rapidxml::xml_document<char> doc;
-	doc.parse<0>(xmlFile.data());
+std::shared_ptr<SirDesc> SirXmlReader::ReadDesc(const SirStore::FileRef& file)
+{
+	return ReadDescXml(file.Stem(), file.Root());
+}
+
+template<typename N>
+static std::shared_ptr<SirFChart> ReadFChartXml(std::string filename, N node_sir)
+{
+	auto sir = std::make_shared<SirFChart>();
+	sir->filename = std::move(filename);
 
-	auto node_sir = doc.first_node();
 	auto node_nodes = node_sir->first_node();
 	auto node_node = node_nodes->first_node();
 	while (node_node != nullptr) {
 		auto n = std::make_shared<SirFChart::Node>();
 		auto attr_node = node_node->first_attribute();
+		static constexpr XmlNameTable node_attrs({ "id1", "id2", "name_jp", "file", "name", "text", "desc_jp", "type1", "command1", "type2" });
 		while (attr_node != nullptr) {
-			if (strcmp(attr_node->name(), "id1") == 0) {
-				n->id1 = utf8_to_mbs(attr_node->value());
-			}
-			else if (strcmp(attr_node->name(), "id2") == 0) {
-				n->id2 = utf8_to_mbs(attr_node->value());
-			}
-			else if (strcmp(attr_node->name(), "name_jp") == 0) {
-				n->name_jp = utf8_to_mbs(attr_node->value());
-			}
-			else if (strcmp(attr_node->name(), "file") == 0) {
-				n->filename = utf8_to_mbs(attr_node->value());
-			}
-			else if (strcmp(attr_node->name(), "name") == 0) {
-				n->name = utf8_to_mbs(attr_node->value());
-			}
-			else if (strcmp(attr_node->name(), "text") == 0) {
-				n->patch_text = utf8_to_wcs(attr_node->value());
-				n->text = wcs_to_mbs(n->patch_text, "");
-			}
-			else if (strcmp(attr_node->name(), "desc_jp") == 0) {
-				n->desc_jp = utf8_to_mbs(attr_node->value());
-			}
-			else if (strcmp(attr_node->name(), "type1") == 0) {
-				n->type_id1 = utf8_to_mbs(attr_node->value());
-			}
-			else if (strcmp(attr_node->name(), "command1") == 0) {
-				n->command1 = utf8_to_mbs(attr_node->value());
-			}
-			else if (strcmp(attr_node->name(), "type2") == 0) {
-				n->type_id2 = utf8_to_mbs(attr_node->value());
+			switch (node_attrs.Find(XmlName(attr_node))) {
+			case node_attrs.Index("id1"):
+				n->id1 = SjisValue(attr_node);
+				break;
+			case node_attrs.Index("id2"):
+				n->id2 = SjisValue(attr_node);
+				break;
+			case node_attrs.Index("name_jp"):
+				n->name_jp = SjisValue(attr_node);
+				break;
+			case node_attrs.Index("file"):
+				n->filename = SjisValue(attr_node);
+				break;
+			case node_attrs.Index("name"):
+				n->name = SjisValue(attr_node);
+				break;
+			case node_attrs.Index("text"):
+				ReadPatchText(attr_node, n->patch_text, n->text);
+				break;
+			case node_attrs.Index("desc_jp"):
+				n->desc_jp = SjisValue(attr_node);
+				break;
+			case node_attrs.Index("type1"):
+				n->type_id1 = SjisValue(attr_node);
+				break;
+			case node_attrs.Index("command1"):
+				n->command1 = SjisValue(attr_node);
+				break;
+			case node_attrs.Index("type2"):
+				n->type_id2 = SjisValue(attr_node);
+				break;
 			}
 			attr_node = attr_node->next_attribute();
 		}
@@ -468,25 +610,27 @@ std::shared_ptr<SirFChart> SirXmlReader::ReadFChart(fs::path file_path)
 			auto item = std::make_shared<SirFChart::Node::Item>();
 
 			auto attr_item = item_node->first_attribute();
+			static constexpr XmlNameTable item_attrs({ "id1", "id2", "name_jp", "file", "name", "text" });
 			while (attr_item != nullptr) {
-				if (strcmp(attr_item->name(), "id1") == 0) {
-					item->id1 = utf8_to_mbs(attr_item->value());
-				}
-				else if (strcmp(attr_item->name(), "id2") == 0) {
-					item->id2 = utf8_to_mbs(attr_item->value());
-				}
-				else if (strcmp(attr_item->name(), "name_jp") == 0) {
-					item->name_jp = utf8_to_mbs(attr_item->value());
-				}
-				else if (strcmp(attr_item->name(), "file") == 0) {
-					item->filename = utf8_to_mbs(attr_item->value());
-				}
-				else if (strcmp(attr_item->name(), "name") == 0) {
-					item->name = utf8_to_mbs(attr_item->value());
-				}
-				else if (strcmp(attr_item->name(), "text") == 0) {
-					item->patch_text = utf8_to_wcs(attr_item->value());
-					item->text = wcs_to_mbs(item->patch_text, "");
+				switch (item_attrs.Find(XmlName(attr_item))) {
+				case item_attrs.Index("id1"):
+					item->id1 = SjisValue(attr_item);
+					break;
+				case item_attrs.Index("id2"):
+					item->id2 = SjisValue(attr_item);
+					break;
+				case item_attrs.Index("name_jp"):
+					item->name_jp = SjisValue(attr_item);
+					break;
+				case item_attrs.Index("file"):
+					item->filename = SjisValue(attr_item);
+					break;
+				case item_attrs.Index("name"):
+					item->name = SjisValue(attr_item);
+					break;
+				case item_attrs.Index("text"):
+					ReadPatchText(attr_item, item->patch_text, item->text);
+					break;
 				}
 				attr_item = attr_item->next_attribute();
 			}
@@ -502,37 +646,44 @@ std::shared_ptr<SirFChart> SirXmlReader::ReadFChart(fs::path file_path)
 	return sir;
 }
 
-std::shared_ptr<SirDoc> SirXmlReader::ReadDoc(fs::path file_path)
+std::shared_ptr<SirFChart> SirXmlReader::ReadFChart(fs::path file_path)
 {
-	auto sir = std::make_shared<SirDoc>();
-	sir->filename = file_path.stem().stem().string();
-	
+	XmlFile doc(file_path);
+	return ReadFChartXml(file_path.stem().stem().string(), doc.first_node());
+}
 
-	rapidxml::file<char> xmlFile(file_path.string().c_str()); // Default template is char
-	rapidxml::xml_document<char> doc;
-	doc.parse<0>(xmlFile.data());
+std::shared_ptr<SirFChart> SirXmlReader::ReadFChart(const SirStore::FileRef& file)
+{
+	return ReadFChartXml(file.Stem(), file.Root());
+}
+
+template<typename N>
+static std::shared_ptr<SirDoc> ReadDocXml(std::string filename, N node_sir)
+{
+	auto sir = std::make_shared<SirDoc>();
+	sir->filename = std::move(filename);
 
-	auto node_sir = doc.first_node();
 	auto node_ns = node_sir->first_node();
 
 	auto node_n = node_ns->first_node();
 	while (node_n != nullptr) {
 		auto n = std::make_shared<SirDoc::Node>();
 		auto attr_n = node_n->first_attribute();
+		static constexpr XmlNameTable n_attrs({ "key1", "key2", "text1", "text2" });
 		while (attr_n != nullptr) {
-			if (strcmp(attr_n->name(), "key1") == 0) {
-				n->key1 = utf8_to_mbs(attr_n->value());
-			}
-			else if (strcmp(attr_n->name(), "key2") == 0) {
-				n->key2 = utf8_to_mbs(attr_n->value());
-			}
-			else if (strcmp(attr_n->name(), "text1") == 0) {
-				n->patch_text1 = utf8_to_wcs(attr_n->value());
-				n->text1 = wcs_to_mbs(n->patch_text1, "");
-			}
-			else if (strcmp(attr_n->name(), "text2") == 0) {
-				n->patch_text2 = utf8_to_wcs(attr_n->value());
-				n->text2 = wcs_to_mbs(n->patch_text2, "");
+			switch (n_attrs.Find(XmlName(attr_n))) {
+			case n_attrs.Index("key1"):
+				n->key1 = SjisValue(attr_n);
+				break;
+			case n_attrs.Index("key2"):
+				n->key2 = SjisValue(attr_n);
+				break;
+			case n_attrs.Index("text1"):
+				ReadPatchText(attr_n, n->patch_text1, n->text1);
+				break;
+			case n_attrs.Index("text2"):
+				ReadPatchText(attr_n, n->patch_text2, n->text2);
+				break;
 			}
 			attr_n = attr_n->next_attribute();
 		}
@@ -541,9 +692,8 @@ std::shared_ptr<SirDoc> SirXmlReader::ReadDoc(fs::path file_path)
 		while (node_i != nullptr) {
 			auto attr_i = node_i->first_attribute();
 			while (attr_i != nullptr) {
-				if (strcmp(attr_i->name(), "text") == 0) {
-					n->patch_contents.push_back(utf8_to_wcs(attr_i->value()));
-					n->contents.push_back(wcs_to_mbs(n->patch_contents.back(), ""));
+				if (XmlName(attr_i) == "text") {
+					ReadPatchText(attr_i, n->patch_contents.emplace_back(), n->contents.emplace_back());
 				}
 				attr_i = attr_i->next_attribute();
 			}
@@ -557,25 +707,31 @@ std::shared_ptr<SirDoc> SirXmlReader::ReadDoc(fs::path file_path)
 	return sir;
 }
 
-std::shared_ptr<SirMap> SirXmlReader::ReadMap(fs::path file_path)
+std::shared_ptr<SirDoc> SirXmlReader::ReadDoc(fs::path file_path)
 {
-	auto sir = std::make_shared<SirMap>();
-	sir->filename = file_path.stem().stem().string();
-	
+	XmlFile doc(file_path);
+	return ReadDocXml(file_path.stem().stem().string(), doc.first_node());
+}
 
-	rapidxml::file<char> xmlFile(file_path.string().c_str()); // Default template is char
-	rapidxml::xml_document<char> doc;
-	doc.parse<0>(xmlFile.data());
+std::shared_ptr<SirDoc> SirXmlReader::ReadDoc(const SirStore::FileRef& file)
+{
+	return ReadDocXml(file.Stem(), file.Root());
+}
+
+template<typename N>
+static std::shared_ptr<SirMap> ReadMapXml(std::string filename, N node_sir)
+{
+	auto sir = std::make_shared<SirMap>();
+	sir->filename = std::move(filename);
 
-	auto node_sir = doc.first_node();
 	auto node_nodes = node_sir->first_node();
 	auto node_node = node_nodes->first_node();
 	while (node_node != nullptr) {
 		auto n = std::make_shared<SirMap::Node>();
 		auto attr_node = node_node->first_attribute();
 		while (attr_node != nullptr) {
-			if (strcmp(attr_node->name(), "name") == 0) {
-				n->name = utf8_to_mbs(attr_node->value());
+			if (XmlName(attr_node) == "name") {
+				n->name = SjisValue(attr_node);
 			}
 			attr_node = attr_node->next_attribute();
 		}
@@ -585,25 +741,27 @@ std::shared_ptr<SirMap> SirXmlReader::ReadMap(fs::path file_path)
 			auto item = std::make_shared<SirMap::Node::Item>();
 
 			auto attr_item = item_node->first_attribute();
+			static constexpr XmlNameTable item_attrs({ "key", "text", "desc", "unknown1", "unknown2", "unknown3" });
 			while (attr_item != nullptr) {
-				if (strcmp(attr_item->name(), "key") == 0) {
-					item->key = utf8_to_mbs(attr_item->value());
-				}
-				else if (strcmp(attr_item->name(), "text") == 0) {
-					item->patch_text = utf8_to_wcs(attr_item->value());
-					item->text = wcs_to_mbs(item->patch_text, "");
-				}
-				else if (strcmp(attr_item->name(), "desc") == 0) {
-					item->desc = utf8_to_mbs(attr_item->value());
-				}
-				else if (strcmp(attr_item->name(), "unknown1") == 0) {
+				switch (item_attrs.Find(XmlName(attr_item))) {
+				case item_attrs.Index("key"):
+					item->key = SjisValue(attr_item);
+					break;
+				case item_attrs.Index("text"):
+					ReadPatchText(attr_item, item->patch_text, item->text);
+					break;
+				case item_attrs.Index("desc"):
+					item->desc = SjisValue(attr_item);
+					break;
+				case item_attrs.Index("unknown1"):
 					item->unknowns[0] = atoi(attr_item->value());
-				}
-				else if (strcmp(attr_item->name(), "unknown2") == 0) {
+					break;
+				case item_attrs.Index("unknown2"):
 					item->unknowns[1] = atoi(attr_item->value());
-				}
-				else if (strcmp(attr_item->name(), "unknown3") == 0) {
+					break;
+				case item_attrs.Index("unknown3"):
 					item->unknowns[2] = atoi(attr_item->value());
+					break;
 				}
 				attr_item = attr_item->next_attribute();
 			}
@@ -619,25 +777,31 @@ std::shared_ptr<SirMap> SirXmlReader::ReadMap(fs::path file_path)
 	return sir;
 }
 
-std::shared_ptr<SirCredit> SirXmlReader::ReadCredit(fs::path file_path)
+std::shared_ptr<SirMap> SirXmlReader::ReadMap(fs::path file_path)
 {
-	auto sir = std::make_shared<SirCredit>();
-	sir->filename = file_path.stem().stem().string();
+	XmlFile doc(file_path);
+	return ReadMapXml(file_path.stem().stem().string(), doc.first_node());
+}
 
+std::shared_ptr<SirMap> SirXmlReader::ReadMap(const SirStore::FileRef& file)
+{
+	return ReadMapXml(file.Stem(), file.Root());
+}
 
-	rapidxml::file<char> xmlFile(file_path.string().c_str()); // Default template is char
-	rapidxml::xml_document<char> doc;
-	doc.parse<0>(xmlFile.data());
+template<typename N>
+static std::shared_ptr<SirCredit> ReadCreditXml(std::string filename, N node_sir)
+{
+	auto sir = std::make_shared<SirCredit>();
+	sir->filename = std::move(filename);
 
-	auto node_sir = doc.first_node();
 	auto node_nodes = node_sir->first_node();
 	auto node_node = node_nodes->first_node();
 	while (node_node != nullptr) {
 		auto n = std::make_shared<SirCredit::Node>();
 		auto attr_node = node_node->first_attribute();
 		while (attr_node != nullptr) {
-			if (strcmp(attr_node->name(), "name") == 0) {
-				n->name = utf8_to_mbs(attr_node->value());
+			if (XmlName(attr_node) == "name") {
+				n->name = SjisValue(attr_node);
 			}
 			attr_node = attr_node->next_attribute();
 		}
@@ -647,13 +811,15 @@ std::shared_ptr<SirCredit> SirXmlReader::ReadCredit(fs::path file_path)
 			auto item = std::make_shared<SirCredit::Node::Item>();
 
 			auto attr_item = item_node->first_attribute();
+			static constexpr XmlNameTable item_attrs({ "id", "text" });
 			while (attr_item != nullptr) {
-				if (strcmp(attr_item->name(), "id") == 0) {
+				switch (item_attrs.Find(XmlName(attr_item))) {
+				case item_attrs.Index("id"):
 					item->id = atoi(attr_item->value());
-				}
-				else if (strcmp(attr_item->name(), "text") == 0) {
-					item->patch_text = utf8_to_wcs(attr_item->value());
-					item->text = wcs_to_mbs(item->patch_text, "");
+					break;
+				case item_attrs.Index("text"):
+					ReadPatchText(attr_item, item->patch_text, item->text);
+					break;
 				}
 				attr_item = attr_item->next_attribute();
 			}
@@ -669,24 +835,31 @@ std::shared_ptr<SirCredit> SirXmlReader::ReadCredit(fs::path file_path)
 	return sir;
 }
 
-std::shared_ptr<SirRoom> SirXmlReader::ReadRoom(fs::path file_path)
+std::shared_ptr<SirCredit> SirXmlReader::ReadCredit(fs::path file_path)
 {
-	auto sir = std::make_shared<SirRoom>();
-	sir->filename = file_path.stem().stem().string();
+	XmlFile doc(file_path);
+	return ReadCreditXml(file_path.stem().stem().string(), doc.first_node());
+}
 
-	rapidxml::file<char> xmlFile(file_path.string().c_str()); // Default template is char
-	rapidxml::xml_document<char> doc;
-	doc.parse<0>(xmlFile.data());
+std::shared_ptr<SirCredit> SirXmlReader::ReadCredit(const SirStore::FileRef& file)
+{
+	return ReadCreditXml(file.Stem(), file.Root());
+}
+
+template<typename N>
+static std::shared_ptr<SirRoom> ReadRoomXml(std::string filename, N node_sir)
+{
+	auto sir = std::make_shared<SirRoom>();
+	sir->filename = std::move(filename);
 
-	auto node_sir = doc.first_node();
 	auto node_nodes = node_sir->first_node();
 	auto node_node = node_nodes->first_node();
 	while (node_node != nullptr) {
 		auto n = std::make_shared<SirRoom::Node>();
 		auto attr_node = node_node->first_attribute();
 		while (attr_node != nullptr) {
-			if (strcmp(attr_node->name(), "name") == 0) {
-				n->name = utf8_to_mbs(attr_node->value());
+			if (XmlName(attr_node) == "name") {
+				n->name = SjisValue(attr_node);
 			}
 			attr_node = attr_node->next_attribute();
 		}
@@ -696,22 +869,24 @@ std::shared_ptr<SirRoom> SirXmlReader::ReadRoom(fs::path file_path)
 			auto item = std::make_shared<SirRoom::Node::Item>();
 
 			auto attr_item = item_node->first_attribute();
+			static constexpr XmlNameTable item_attrs({ "id", "text", "key", "in", "out" });
 			while (attr_item != nullptr) {
-				if (strcmp(attr_item->name(), "id") == 0) {
-					item->id = utf8_to_mbs(attr_item->value());
-				}
-				else if (strcmp(attr_item->name(), "text") == 0) {
-					item->patch_text = utf8_to_wcs(attr_item->value());
-					item->text = wcs_to_mbs(item->patch_text, "");
-				}
-				else if (strcmp(attr_item->name(), "key") == 0) {
-					item->key = utf8_to_mbs(attr_item->value());
-				}
-				else if (strcmp(attr_item->name(), "in") == 0) {
-					item->in = utf8_to_mbs(attr_item->value());
-				}
-				else if (strcmp(attr_item->name(), "out") == 0) {
-					item->out = utf8_to_mbs(attr_item->value());
+				switch (item_attrs.Find(XmlName(attr_item))) {
+				case item_attrs.Index("id"):
+					item->id = SjisValue(attr_item);
+					break;
+				case item_attrs.Index("text"):
+					ReadPatchText(attr_item, item->patch_text, item->text);
+					break;
+				case item_attrs.Index("key"):
+					item->key = SjisValue(attr_item);
+					break;
+				case item_attrs.Index("in"):
+					item->in = SjisValue(attr_item);
+					break;
+				case item_attrs.Index("out"):
+					item->out = SjisValue(attr_item);
+					break;
 				}
 				attr_item = attr_item->next_attribute();
 			}
@@ -725,4 +900,15 @@ std::shared_ptr<SirRoom> SirXmlReader::ReadRoom(fs::path file_path)
 	}
 
 	return sir;
+}
+
+std::shared_ptr<SirRoom> SirXmlReader::ReadRoom(fs::path file_path)
+{
+	XmlFile doc(file_path);
+	return ReadRoomXml(file_path.stem().stem().string(), doc.first_node());
+}
+
+std::shared_ptr<SirRoom> SirXmlReader::ReadRoom(const SirStore::FileRef& file)
+{
+	return ReadRoomXml(file.Stem(), file.Root());
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Sir.hpp"
+#include "SirStore.hpp"
 
 class SirXmlReader
 {
@@ -16,4 +17,16 @@ public:
 	static std::shared_ptr<SirMap> ReadMap(fs::path file_path);
 	static std::shared_ptr<SirCredit> ReadCredit(fs::path file_path);
 	static std::shared_ptr<SirRoom> ReadRoom(fs::path file_path);
+
+	// the same readers over a file of a translation store, fonts are never stored.
+	static std::shared_ptr<SirDlg> ReadDlg(const SirStore::FileRef& file);
+	static std::shared_ptr<SirName> ReadName(const SirStore::FileRef& file);
+	static std::shared_ptr<SirItem> ReadItem(const SirStore::FileRef& file);
+	static std::shared_ptr<SirMsg> ReadMsg(const SirStore::FileRef& file);
+	static std::shared_ptr<SirDesc> ReadDesc(const SirStore::FileRef& file);
+	static std::shared_ptr<SirFChart> ReadFChart(const SirStore::FileRef& file);
+	static std::shared_ptr<SirDoc> ReadDoc(const SirStore::FileRef& file);
+	static std::shared_ptr<SirMap> ReadMap(const SirStore::FileRef& file);
+	static std::shared_ptr<SirCredit> ReadCredit(const SirStore::FileRef& file);
+	static std::shared_ptr<SirRoom> ReadRoom(const SirStore::FileRef& file);
 };
\ No newline at end of file
@@ -2,36 +2,70 @@
 
 #include "Sir.hpp"
 #include "SirPngWriter.hpp"
+#include "ThreadPool.hpp"
 
 class SirXmlWriter
 {
 public:
+	// written is cleared when a file can't be written.
 	template <typename T>
-	static void WriteAll(std::vector<std::shared_ptr<T>>& sirs, const fs::path& dst_dir_path)
+	static void AddWrites(const std::vector<std::shared_ptr<T>>& sirs, const fs::path& dst_dir_path, ThreadPool::Tasks& tasks, std::atomic_bool& written)
 	{
 		for (auto& sir : sirs) {
-			Write(*sir, fs::path(dst_dir_path).append(sir->filename + T::XmlExtension));
+			tasks.push_back([sir = sir.get(), dst_dir_path, &written]() {
+				if (!Write(*sir, fs::path(dst_dir_path).append(sir->filename + T::XmlExtension))) {
+					written = false;
+				}
+			});
 		}
 	}
-	template<>
-	static void WriteAll(std::vector<std::shared_ptr<SirFont>>& sirs, const fs::path& dst_dir_path)
+	// the two png pages are encoded as tasks of their own, they take far longer than the xml.
+	// the pages are laid out first, the xml and the png of a page share the layout.
+	static void AddWrites(const std::vector<std::shared_ptr<SirFont>>& sirs, const fs::path& dst_dir_path, ThreadPool::Tasks& tasks, std::atomic_bool& written)
 	{
-		for (auto& sir : sirs) {
-			Write(*sir, fs::path(dst_dir_path).append(sir->filename + SirFont::XmlExtension));
-			SirPngWriter::Write(*sir, 0, fs::path(dst_dir_path).append(sir->filename + SirFont::DefaultPngExtension));
-			SirPngWriter::Write(*sir, 1, fs::path(dst_dir_path).append(sir->filename + SirFont::BorderPngExtension));
+		auto atlases = std::make_shared<std::vector<std::array<SirPngWriter::Atlas, 2>>>(sirs.size());
+		ThreadPool::Shared().ParallelFor(sirs.size() * 2, [&](std::size_t k) {
+			(*atlases)[k / 2][k % 2] = SirPngWriter::Layout(*sirs[k / 2], (int)(k % 2));
+		});
+		for (std::size_t s = 0; s < sirs.size(); s++) {
+			auto atlas = &(*atlases)[s];
+			tasks.push_back([sir = sirs[s].get(), atlas, atlases, dst_dir_path, &written]() {
+				if (!Write(*sir, *atlas, fs::path(dst_dir_path).append(sir->filename + SirFont::XmlExtension))) {
+					written = false;
+				}
+			});
+			tasks.push_back([sir = sirs[s].get(), atlas, atlases, dst_dir_path, &written]() {
+				if (!SirPngWriter::Write(*sir, 0, (*atlas)[0], fs::path(dst_dir_path).append(sir->filename + SirFont::DefaultPngExtension))) {
+					written = false;
+				}
+			});
+			tasks.push_back([sir = sirs[s].get(), atlas, atlases, dst_dir_path, &written]() {
+				if (!SirPngWriter::Write(*sir, 1, (*atlas)[1], fs::path(dst_dir_path).append(sir->filename + SirFont::BorderPngExtension))) {
+					written = false;
+				}
+			});
 		}
 	}
+	template <typename T>
+	static bool WriteAll(std::vector<std::shared_ptr<T>>& sirs, const fs::path& dst_dir_path)
+	{
+		std::atomic_bool written = true;
+		ThreadPool::Tasks tasks;
+		AddWrites(sirs, dst_dir_path, tasks, written);
+		ThreadPool::Shared().RunAll(tasks);
+		return written;
+	}
 
-	static void Write(const SirDlg& sir, fs::path file_path);
-	static void Write(const SirName& sir, fs::path file_path);
-	static void Write(const SirFont& sir, fs::path file_path);
-	static void Write(const SirItem& sir, fs::path file_path);
-	static void Write(const SirMsg& sir, fs::path file_path);
-	static void Write(const SirDesc& sir, fs::path file_path);
-	static void Write(const SirFChart& sir, fs::path file_path);
-	static void Write(const SirDoc& sir, fs::path file_path);
-	static void Write(const SirMap& sir, fs::path file_path);
-	static void Write(const SirCredit& sir, fs::path file_path);
-	static void Write(const SirRoom& sir, fs::path file_path);
+	static bool Write(const SirDlg& sir, fs::path file_path);
+	static bool Write(const SirName& sir, fs::path file_path);
+	// atlas is where SirPngWriter puts the glyphs of each page.
+	static bool Write(const SirFont& sir, const std::array<SirPngWriter::Atlas, 2>& atlas, fs::path file_path);
+	static bool Write(const SirItem& sir, fs::path file_path);
+	static bool Write(const SirMsg& sir, fs::path file_path);
+	static bool Write(const SirDesc& sir, fs::path file_path);
+	static bool Write(const SirFChart& sir, fs::path file_path);
+	static bool Write(const SirDoc& sir, fs::path file_path);
+	static bool Write(const SirMap& sir, fs::path file_path);
+	static bool Write(const SirCredit& sir, fs::path file_path);
+	static bool Write(const SirRoom& sir, fs::path file_path);
 };
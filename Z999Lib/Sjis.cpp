@@ -0,0 +1,248 @@
+#include "Sjis.hpp"
+#include "Utf.hpp"
+
+#include <algorithm>
+
+namespace sjis
+{
+#include "SjisTable.inl"
+
+	static constexpr int lead_index(uint8_t lead)
+	{
+		if (lead >= 0x81 && lead <= 0x9F) {
+			return lead - 0x81;
+		}
+		if (lead >= 0xE0 && lead <= 0xFC) {
+			return lead - 0xE0 + 31;
+		}
+		return -1;
+	}
+
+	static constexpr code_bitmap double_byte_valid = [] {
+		code_bitmap bits{};
+		for (int lead = 0x81; lead <= 0xFC; lead++) {
+			if (lead_index((uint8_t)lead) < 0) {
+				continue;
+			}
+			for (int trail = 0x40; trail <= 0xFC; trail++) {
+				if (double_byte_table[lead_index((uint8_t)lead) * 189 + (trail - 0x40)] != 0) {
+					auto code = (lead << 8) | trail;
+					bits[code >> 6] |= 1ULL << (code & 63);
+				}
+			}
+		}
+		return bits;
+	}();
+
+	const code_bitmap& double_byte_bitmap()
+	{
+		return double_byte_valid;
+	}
+
+	static constexpr uint16_t encode(char32_t ch)
+	{
+		return ch > 0xFFFF ? unmapped : encode_blocks[encode_pages[ch >> 8]][ch & 0xFF];
+	}
+
+	char16_t to_unicode(uint8_t c)
+	{
+		if (c <= 0x7F) {
+			return c;
+		}
+		if (c >= 0xA1 && c <= 0xDF) {
+			return (char16_t)(0xFF61 + (c - 0xA1));
+		}
+		return unmapped;
+	}
+
+	char16_t to_unicode(uint8_t lead, uint8_t trail)
+	{
+		auto li = lead_index(lead);
+		if (li < 0 || !is_trail(trail)) {
+			return unmapped;
+		}
+		auto u = double_byte_table[li * 189 + (trail - 0x40)];
+		return u == 0 ? unmapped : u;
+	}
+
+	uint16_t from_unicode(char32_t ch)
+	{
+		return encode(ch);
+	}
+
+	// decodes the non-ascii character at src[i], unmapped on error.
+	static char16_t decode_one(std::string_view src, std::size_t& i)
+	{
+		auto c = (uint8_t)src[i++];
+		if (!is_lead(c)) {
+			return to_unicode(c);
+		}
+		if (i >= src.size()) {
+			return unmapped;
+		}
+		return to_unicode(c, (uint8_t)src[i++]);
+	}
+
+	static char* put_utf8(char* out, char16_t u)
+	{
+		if (u < 0x80) {
+			*out++ = (char)u;
+		}
+		else if (u < 0x800) {
+			*out++ = (char)(0xC0 | (u >> 6));
+			*out++ = (char)(0x80 | (u & 0x3F));
+		}
+		else {
+			*out++ = (char)(0xE0 | (u >> 12));
+			*out++ = (char)(0x80 | ((u >> 6) & 0x3F));
+			*out++ = (char)(0x80 | (u & 0x3F));
+		}
+		return out;
+	}
+
+	static char* put_sjis(char* out, uint16_t code)
+	{
+		if (code > 0xFF) {
+			*out++ = (char)(code >> 8);
+		}
+		*out++ = (char)code;
+		return out;
+	}
+
+	error to_wcs(std::string_view src, std::wstring& dst)
+	{
+		dst.resize(src.size());
+		auto out = dst.data();
+		std::size_t i = 0;
+		while (i < src.size()) {
+			auto n = utf::widen_ascii(src.data() + i, src.size() - i, out);
+			i += n;
+			out += n;
+			if (i == src.size()) {
+				break;
+			}
+			auto u = decode_one(src, i);
+			if (u == unmapped) {
+				dst.clear();
+				return error::invalid_sequence;
+			}
+			*out++ = (wchar_t)u;
+		}
+		dst.resize(out - dst.data());
+		return error::none;
+	}
+
+	error to_utf8(std::string_view src, std::string& dst)
+	{
+		dst.resize(src.size() * 3);
+		auto out = dst.data();
+		std::size_t i = 0;
+		while (i < src.size()) {
+			auto n = utf::ascii_length(src.data() + i, src.size() - i);
+			std::copy_n(src.data() + i, n, out);
+			i += n;
+			out += n;
+			if (i == src.size()) {
+				break;
+			}
+			auto u = decode_one(src, i);
+			if (u == unmapped) {
+				dst.clear();
+				return error::invalid_sequence;
+			}
+			out = put_utf8(out, u);
+		}
+		dst.resize(out - dst.data());
+		return error::none;
+	}
+
+	error from_wcs(std::wstring_view src, std::string& dst)
+	{
+		dst.resize(src.size() * 2);
+		auto out = dst.data();
+		std::size_t i = 0;
+		while (i < src.size()) {
+			auto n = utf::narrow_ascii(src.data() + i, src.size() - i, out);
+			i += n;
+			out += n;
+			if (i == src.size()) {
+				break;
+			}
+			auto ch = src[i++];
+			auto code = encode((char32_t)ch);
+			if (code == unmapped) {
+				dst.clear();
+				return error::unmappable;
+			}
+			out = put_sjis(out, code);
+		}
+		dst.resize(out - dst.data());
+		return error::none;
+	}
+
+	error from_utf8(std::string_view src, std::string& dst)
+	{
+		dst.resize(src.size());
+		auto out = dst.data();
+		auto p = (const uint8_t*)src.data();
+		auto end = p + src.size();
+		auto err = error::none;
+		while (p < end) {
+			auto n = utf::ascii_length((const char*)p, end - p);
+			std::copy_n(p, n, out);
+			p += n;
+			out += n;
+			if (p == end) {
+				break;
+			}
+
+			char32_t ch = *p;
+			if (ch >= 0xC2 && ch <= 0xDF && end - p >= 2 && (p[1] & 0xC0) == 0x80) {
+				ch = ((ch & 0x1F) << 6) | (p[1] & 0x3F);
+				p += 2;
+			}
+			else if (ch >= 0xE0 && ch <= 0xEF && end - p >= 3 && (p[1] & 0xC0) == 0x80 && (p[2] & 0xC0) == 0x80) {
+				ch = ((ch & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+				if (ch < 0x800 || (ch >= 0xD800 && ch <= 0xDFFF)) {
+					err = error::invalid_sequence;
+					break;
+				}
+				p += 3;
+			}
+			else if (ch >= 0xF0 && ch <= 0xF4 && end - p >= 4 && (p[1] & 0xC0) == 0x80 && (p[2] & 0xC0) == 0x80 && (p[3] & 0xC0) == 0x80) {
+				// outside of the bmp, nothing in cp932
+				err = error::unmappable;
+				break;
+			}
+			else {
+				err = error::invalid_sequence;
+				break;
+			}
+
+			auto code = encode(ch);
+			if (code == unmapped) {
+				err = error::unmappable;
+				break;
+			}
+			out = put_sjis(out, code);
+		}
+		if (err != error::none) {
+			dst.clear();
+			return err;
+		}
+		dst.resize(out - dst.data());
+		return error::none;
+	}
+
+	bool valid(std::string_view src)
+	{
+		std::size_t i = 0;
+		while (i < src.size()) {
+			i += utf::ascii_length(src.data() + i, src.size() - i);
+			if (i < src.size() && decode_one(src, i) == unmapped) {
+				return false;
+			}
+		}
+		return true;
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// built-in cp932 codec, does not depend on the crt locale.
+namespace sjis
+{
+	enum class error
+	{
+		none = 0,
+		invalid_sequence,
+		unmappable,
+	};
+
+	// code point / sjis code which is not defined
+	static constexpr uint16_t unmapped = 0xFFFF;
+
+	constexpr bool is_lead(uint8_t c)
+	{
+		return (c >= 0x81 && c <= 0x9F) || (c >= 0xE0 && c <= 0xFC);
+	}
+	constexpr bool is_trail(uint8_t c)
+	{
+		return c >= 0x40 && c <= 0xFC && c != 0x7F;
+	}
+
+	// one bit per (lead << 8) | trail, set for every double-byte code which decodes.
+	using code_bitmap = std::array<uint64_t, 0x10000 / 64>;
+	const code_bitmap& double_byte_bitmap();
+
+	inline bool is_valid_double_byte(uint16_t code)
+	{
+		return (double_byte_bitmap()[code >> 6] >> (code & 63)) & 1;
+	}
+
+	char16_t to_unicode(uint8_t c);
+	char16_t to_unicode(uint8_t lead, uint8_t trail);
+
+	// double-byte codes are returned as (lead << 8) | trail.
+	uint16_t from_unicode(char32_t ch);
+
+	// dst is overwritten and cleared on error.
+	error to_wcs(std::string_view src, std::wstring& dst);
+	error to_utf8(std::string_view src, std::string& dst);
+	error from_wcs(std::wstring_view src, std::string& dst);
+	error from_utf8(std::string_view src, std::string& dst);
+
+	bool valid(std::string_view src);
+}
@@ -0,0 +1,326 @@
+#pragma once
+
+#include "Common.hpp"
+
+#include <condition_variable>
+#include <functional>
+
+// worker threads shared by the tools, started on first use.
+// every worker has its own task queue, tasks pushed by a worker go to its queue and idle workers steal from the others.
+// tasks pushed from outside the pool go to a shared queue.
+class ThreadPool
+{
+public:
+	// threads working at once, the calling thread included. 0 is one per hardware thread.
+	// only read when Shared() is first called, the --jobs option sets it.
+	static inline std::size_t jobs = 0;
+
+	explicit ThreadPool(std::size_t thread_count)
+		: queues(thread_count)
+	{
+		workers.reserve(thread_count);
+		for (std::size_t i = 0; i < thread_count; i++) {
+			workers.emplace_back([this, i]() { WorkerLoop(i); });
+		}
+	}
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		cv.notify_all();
+		for (auto& t : workers) {
+			t.join();
+		}
+	}
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	static ThreadPool& Shared()
+	{
+		static ThreadPool pool((jobs > 0 ? jobs : std::max<std::size_t>(std::thread::hardware_concurrency(), 1)) - 1);
+		return pool;
+	}
+
+	// worker threads, the thread waiting on the pool works as well.
+	std::size_t Size() const { return workers.size(); }
+
+	// calls func(i) for every i in [0, count) and returns when all of them are done.
+	// the calling thread takes indices too and runs queued tasks while it waits, so nested calls can't starve the pool.
+	// the first exception thrown by func is rethrown here once the other indices have finished.
+	template<typename F>
+	void ParallelFor(std::size_t count, F func)
+	{
+		if (count == 0) {
+			return;
+		}
+
+		struct State
+		{
+			std::atomic<std::size_t> next = 0;
+			std::atomic<std::size_t> finished = 0;
+			std::mutex error_mutex;
+			std::exception_ptr error;
+		};
+		State state;
+
+		auto func_run = [&]() {
+			for (auto idx = state.next++; idx < count; idx = state.next++) {
+				try {
+					func(idx);
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> lock(state.error_mutex);
+					if (!state.error) {
+						state.error = std::current_exception();
+					}
+				}
+			}
+		};
+
+		auto helper_count = std::min(Size(), count - 1);
+		for (std::size_t i = 0; i < helper_count; i++) {
+			Push([&]() {
+				func_run();
+				state.finished++;
+				Signal();
+			});
+		}
+
+		func_run();
+		HelpUntil([&]() { return state.finished == helper_count; });
+
+		if (state.error) {
+			std::rethrow_exception(state.error);
+		}
+	}
+
+	using Tasks = std::vector<std::function<void()>>;
+
+	void RunAll(const Tasks& tasks)
+	{
+		ParallelFor(tasks.size(), [&](std::size_t i) { tasks[i](); });
+	}
+
+	// tasks started one by one and waited for together.
+	// Wait() runs queued tasks until all of them are done and rethrows the first exception one of them threw.
+	class TaskGroup
+	{
+	public:
+		explicit TaskGroup(ThreadPool& pool = ThreadPool::Shared()) : pool(pool) {}
+		~TaskGroup()
+		{
+			try {
+				Wait();
+			}
+			catch (...) {
+			}
+		}
+		TaskGroup(const TaskGroup&) = delete;
+		TaskGroup& operator=(const TaskGroup&) = delete;
+
+		template<typename F>
+		void Run(F func)
+		{
+			pending++;
+			pool.Push([this, &pool = pool, func]() {
+				try {
+					func();
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> lock(error_mutex);
+					if (!error) {
+						error = std::current_exception();
+					}
+				}
+				// the group can be gone as soon as pending is 0.
+				pending--;
+				pool.Signal();
+			});
+		}
+
+		void Wait()
+		{
+			pool.HelpUntil([this]() { return pending == 0; });
+
+			std::exception_ptr e;
+			{
+				std::lock_guard<std::mutex> lock(error_mutex);
+				std::swap(e, error);
+			}
+			if (e) {
+				std::rethrow_exception(e);
+			}
+		}
+
+	private:
+		ThreadPool& pool;
+		std::atomic<std::size_t> pending = 0;
+		std::mutex error_mutex;
+		std::exception_ptr error;
+	};
+
+	// produce fills the next item on the calling thread and returns false when there is none left,
+	// consume runs on the pool. at most in_flight items are between the two, each one is reused once consumed.
+	template<typename T, typename P, typename C>
+	void Pipeline(std::size_t in_flight, P produce, C consume)
+	{
+		in_flight = std::max<std::size_t>(in_flight, 1);
+		std::vector<T> items(in_flight);
+		std::vector<std::size_t> free_items(in_flight);
+		for (std::size_t i = 0; i < in_flight; i++) {
+			free_items[i] = in_flight - 1 - i;
+		}
+		std::mutex free_mutex;
+		std::atomic<std::size_t> free_count = in_flight;
+
+		auto func_release = [&](std::size_t idx) {
+			{
+				std::lock_guard<std::mutex> lock(free_mutex);
+				free_items.push_back(idx);
+			}
+			free_count++;
+			Signal();
+		};
+
+		TaskGroup group(*this);
+		while (true) {
+			HelpUntil([&]() { return free_count > 0; });
+
+			std::size_t idx;
+			{
+				std::lock_guard<std::mutex> lock(free_mutex);
+				idx = free_items.back();
+				free_items.pop_back();
+			}
+			free_count--;
+
+			if (!produce(items[idx])) {
+				break;
+			}
+			group.Run([&, idx]() {
+				try {
+					consume(items[idx]);
+				}
+				catch (...) {
+					func_release(idx);
+					throw;
+				}
+				func_release(idx);
+			});
+		}
+		group.Wait();
+	}
+
+private:
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	void Push(std::function<void()> task)
+	{
+		auto& queue = current_pool == this ? queues[current_index] : injected;
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.tasks.push_back(std::move(task));
+			queued++;
+		}
+		Signal();
+	}
+
+	// the own queue newest first, then the shared queue, then the oldest task of another worker.
+	bool Pop(std::function<void()>& task)
+	{
+		auto func_take = [&](Queue& queue, bool newest) {
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (queue.tasks.empty()) {
+				return false;
+			}
+			if (newest) {
+				task = std::move(queue.tasks.back());
+				queue.tasks.pop_back();
+			}
+			else {
+				task = std::move(queue.tasks.front());
+				queue.tasks.pop_front();
+			}
+			queued--;
+			return true;
+		};
+
+		auto own = current_pool == this ? current_index : queues.size();
+		if (own < queues.size() && func_take(queues[own], true)) {
+			return true;
+		}
+		if (func_take(injected, false)) {
+			return true;
+		}
+		for (std::size_t i = 1; i <= queues.size(); i++) {
+			auto victim = (own + i) % queues.size();
+			if (victim != own && func_take(queues[victim], false)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool RunOne()
+	{
+		std::function<void()> task;
+		if (!Pop(task)) {
+			return false;
+		}
+		task();
+		return true;
+	}
+
+	// runs queued tasks until done() holds, whoever makes it hold calls Signal().
+	template<typename F>
+	void HelpUntil(F done)
+	{
+		while (!done()) {
+			if (!RunOne()) {
+				std::unique_lock<std::mutex> lock(mutex);
+				cv.wait(lock, [&]() { return done() || queued > 0; });
+			}
+		}
+	}
+
+	void Signal()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+		}
+		cv.notify_all();
+	}
+
+	void WorkerLoop(std::size_t idx)
+	{
+		current_pool = this;
+		current_index = idx;
+		while (true) {
+			if (RunOne()) {
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(mutex);
+			cv.wait(lock, [this]() { return stopping || queued > 0; });
+			if (stopping && queued == 0) {
+				return;
+			}
+		}
+	}
+
+	static inline thread_local ThreadPool* current_pool = nullptr;
+	static inline thread_local std::size_t current_index = 0;
+
+	std::vector<Queue> queues;
+	Queue injected;
+	std::atomic<std::size_t> queued = 0;
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable cv;
+	bool stopping = false;
+};
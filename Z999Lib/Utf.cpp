@@ -0,0 +1,210 @@
+#include "Utf.hpp"
+
+#include <bit>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define M_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace utf
+{
+	std::size_t ascii_length(const char* src, std::size_t size)
+	{
+		std::size_t i = 0;
+#ifdef M_USE_SSE2
+		for (; i + 16 <= size; i += 16) {
+			auto mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(src + i)));
+			if (mask != 0) {
+				return i + std::countr_zero((uint32_t)mask);
+			}
+		}
+#endif
+		while (i < size && (uint8_t)src[i] < 0x80) {
+			i++;
+		}
+		return i;
+	}
+
+	std::size_t widen_ascii(const char* src, std::size_t size, wchar_t* dst)
+	{
+		std::size_t i = 0;
+#ifdef M_USE_SSE2
+		auto zero = _mm_setzero_si128();
+		for (; i + 16 <= size; i += 16) {
+			auto v = _mm_loadu_si128((const __m128i*)(src + i));
+			if (_mm_movemask_epi8(v) != 0) {
+				break;
+			}
+			auto lo = _mm_unpacklo_epi8(v, zero);
+			auto hi = _mm_unpackhi_epi8(v, zero);
+			if constexpr (sizeof(wchar_t) == 2) {
+				_mm_storeu_si128((__m128i*)(dst + i), lo);
+				_mm_storeu_si128((__m128i*)(dst + i + 8), hi);
+			}
+			else {
+				_mm_storeu_si128((__m128i*)(dst + i), _mm_unpacklo_epi16(lo, zero));
+				_mm_storeu_si128((__m128i*)(dst + i + 4), _mm_unpackhi_epi16(lo, zero));
+				_mm_storeu_si128((__m128i*)(dst + i + 8), _mm_unpacklo_epi16(hi, zero));
+				_mm_storeu_si128((__m128i*)(dst + i + 12), _mm_unpackhi_epi16(hi, zero));
+			}
+		}
+#endif
+		for (; i < size && (uint8_t)src[i] < 0x80; i++) {
+			dst[i] = (wchar_t)src[i];
+		}
+		return i;
+	}
+
+	std::size_t narrow_ascii(const wchar_t* src, std::size_t size, char* dst)
+	{
+		std::size_t i = 0;
+#ifdef M_USE_SSE2
+		auto zero = _mm_setzero_si128();
+		for (; i + 16 <= size; i += 16) {
+			auto p = (const __m128i*)(src + i);
+			__m128i lo, hi;
+			if constexpr (sizeof(wchar_t) == 2) {
+				lo = _mm_loadu_si128(p);
+				hi = _mm_loadu_si128(p + 1);
+				auto over = _mm_and_si128(_mm_or_si128(lo, hi), _mm_set1_epi16((short)0xFF80));
+				if (_mm_movemask_epi8(_mm_cmpeq_epi16(over, zero)) != 0xFFFF) {
+					break;
+				}
+			}
+			else {
+				auto v0 = _mm_loadu_si128(p);
+				auto v1 = _mm_loadu_si128(p + 1);
+				auto v2 = _mm_loadu_si128(p + 2);
+				auto v3 = _mm_loadu_si128(p + 3);
+				auto over = _mm_and_si128(_mm_or_si128(_mm_or_si128(v0, v1), _mm_or_si128(v2, v3)), _mm_set1_epi32((int)0xFFFFFF80));
+				if (_mm_movemask_epi8(_mm_cmpeq_epi32(over, zero)) != 0xFFFF) {
+					break;
+				}
+				lo = _mm_packs_epi32(v0, v1);
+				hi = _mm_packs_epi32(v2, v3);
+			}
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+		}
+#endif
+		for (; i < size && (uint32_t)src[i] < 0x80; i++) {
+			dst[i] = (char)src[i];
+		}
+		return i;
+	}
+
+	error to_wcs(std::string_view src, std::wstring& dst)
+	{
+		// every unit of output consumes at least one byte, 4-byte sequences become a surrogate pair.
+		dst.resize(src.size());
+		auto out = dst.data();
+		auto p = (const uint8_t*)src.data();
+		auto end = p + src.size();
+		while (p < end) {
+			auto n = widen_ascii((const char*)p, end - p, out);
+			p += n;
+			out += n;
+			if (p == end) {
+				break;
+			}
+
+			char32_t ch = *p;
+			std::size_t len;
+			char32_t min;
+			if (ch >= 0xC2 && ch <= 0xDF) {
+				ch &= 0x1F;
+				len = 2;
+				min = 0x80;
+			}
+			else if (ch >= 0xE0 && ch <= 0xEF) {
+				ch &= 0x0F;
+				len = 3;
+				min = 0x800;
+			}
+			else if (ch >= 0xF0 && ch <= 0xF4) {
+				ch &= 0x07;
+				len = 4;
+				min = 0x10000;
+			}
+			else {
+				dst.clear();
+				return error::invalid_sequence;
+			}
+			if ((std::size_t)(end - p) < len) {
+				dst.clear();
+				return error::invalid_sequence;
+			}
+			for (std::size_t i = 1; i < len; i++) {
+				if ((p[i] & 0xC0) != 0x80) {
+					dst.clear();
+					return error::invalid_sequence;
+				}
+				ch = (ch << 6) | (p[i] & 0x3F);
+			}
+			if (ch < min || ch > 0x10FFFF || (ch >= 0xD800 && ch <= 0xDFFF)) {
+				dst.clear();
+				return error::invalid_sequence;
+			}
+			p += len;
+
+			if (sizeof(wchar_t) == 2 && ch > 0xFFFF) {
+				ch -= 0x10000;
+				*out++ = (wchar_t)(0xD800 | (ch >> 10));
+				*out++ = (wchar_t)(0xDC00 | (ch & 0x3FF));
+			}
+			else {
+				*out++ = (wchar_t)ch;
+			}
+		}
+		dst.resize(out - dst.data());
+		return error::none;
+	}
+
+	error from_wcs(std::wstring_view src, std::string& dst)
+	{
+		// at most 3 bytes per utf-16 unit (a surrogate pair takes 4 bytes for 2 units), 4 per utf-32 unit.
+		dst.resize(src.size() * (sizeof(wchar_t) == 2 ? 3 : 4));
+		auto out = dst.data();
+		auto p = src.data();
+		auto end = p + src.size();
+		while (p < end) {
+			auto n = narrow_ascii(p, end - p, out);
+			p += n;
+			out += n;
+			if (p == end) {
+				break;
+			}
+
+			auto ch = (char32_t)*p++;
+			if (ch >= 0xD800 && ch <= 0xDBFF && sizeof(wchar_t) == 2) {
+				if (p == end || (char32_t)*p < 0xDC00 || (char32_t)*p > 0xDFFF) {
+					dst.clear();
+					return error::invalid_sequence;
+				}
+				ch = 0x10000 + ((ch - 0xD800) << 10) + ((char32_t)*p++ - 0xDC00);
+			}
+			else if ((ch >= 0xD800 && ch <= 0xDFFF) || ch > 0x10FFFF) {
+				dst.clear();
+				return error::invalid_sequence;
+			}
+
+			if (ch < 0x800) {
+				*out++ = (char)(0xC0 | (ch >> 6));
+				*out++ = (char)(0x80 | (ch & 0x3F));
+			}
+			else if (ch < 0x10000) {
+				*out++ = (char)(0xE0 | (ch >> 12));
+				*out++ = (char)(0x80 | ((ch >> 6) & 0x3F));
+				*out++ = (char)(0x80 | (ch & 0x3F));
+			}
+			else {
+				*out++ = (char)(0xF0 | (ch >> 18));
+				*out++ = (char)(0x80 | ((ch >> 12) & 0x3F));
+				*out++ = (char)(0x80 | ((ch >> 6) & 0x3F));
+				*out++ = (char)(0x80 | (ch & 0x3F));
+			}
+		}
+		dst.resize(out - dst.data());
+		return error::none;
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// utf-8 <-> wchar_t (utf-16 on windows) without std::wstring_convert.
+namespace utf
+{
+	enum class error
+	{
+		none = 0,
+		invalid_sequence,
+	};
+
+	// leading ascii run, converted 16 units at a time where sse2 is available. returns the run length.
+	std::size_t ascii_length(const char* src, std::size_t size);
+	std::size_t widen_ascii(const char* src, std::size_t size, wchar_t* dst);
+	std::size_t narrow_ascii(const wchar_t* src, std::size_t size, char* dst);
+
+	// dst is overwritten and cleared on error, its capacity is reused.
+	error to_wcs(std::string_view src, std::wstring& dst);
+	error from_wcs(std::wstring_view src, std::string& dst);
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "Common.hpp"
+
+// writes the same bytes as rapidxml::print with default flags, without building a document.
+class XmlEmitter
+{
+public:
+	void Clear()
+	{
+		buffer.clear();
+		stack.clear();
+	}
+
+	void Open(std::string_view name)
+	{
+		if (!stack.empty() && !stack.back().has_children) {
+			buffer += ">\n";
+			stack.back().has_children = true;
+		}
+		buffer.append(stack.size(), '\t');
+		buffer += '<';
+		buffer += name;
+		stack.push_back({ name, false });
+	}
+
+	void Close()
+	{
+		auto& e = stack.back();
+		if (!e.has_children) {
+			buffer += "/>\n";
+		}
+		else {
+			buffer.append(stack.size() - 1, '\t');
+			buffer += "</";
+			buffer += e.name;
+			buffer += ">\n";
+		}
+		stack.pop_back();
+		if (stack.empty()) {
+			buffer += '\n'; // the document node
+		}
+	}
+
+	void Attribute(std::string_view name, std::string_view value)
+	{
+		// rapidxml takes the value as a c string
+		value = value.substr(0, value.find('\0'));
+
+		buffer += ' ';
+		buffer += name;
+		buffer += '=';
+		if (value.find_first_of("<>&'\"") == std::string_view::npos) {
+			buffer += '"';
+			buffer += value;
+			buffer += '"';
+			return;
+		}
+
+		auto quote = value.find('"') != std::string_view::npos ? '\'' : '"';
+		buffer += quote;
+		for (auto c : value) {
+			if (c == (quote == '"' ? '\'' : '"')) {
+				buffer += c;
+				continue;
+			}
+			switch (c) {
+			case '<': buffer += "&lt;"; break;
+			case '>': buffer += "&gt;"; break;
+			case '\'': buffer += "&apos;"; break;
+			case '"': buffer += "&quot;"; break;
+			case '&': buffer += "&amp;"; break;
+			default: buffer += c; break;
+			}
+		}
+		buffer += quote;
+	}
+	void Attribute(std::string_view name, const char* value)
+	{
+		Attribute(name, std::string_view(value));
+	}
+	void Attribute(std::string_view name, const std::string& value)
+	{
+		Attribute(name, std::string_view(value));
+	}
+	template<typename T> requires std::is_arithmetic_v<T>
+	void Attribute(std::string_view name, T value)
+	{
+		Attribute(name, std::string_view(std::to_string(value)));
+	}
+
+	// sjis text is written as utf-8, or as is when it does not decode (same as mbs_to_utf8).
+	void SjisAttribute(std::string_view name, std::string_view value)
+	{
+		value = value.substr(0, value.find('\0'));
+		if (sjis::to_utf8(value, scratch) != sjis::error::none) {
+			Attribute(name, value);
+			return;
+		}
+		Attribute(name, std::string_view(scratch));
+	}
+
+	// one write for the whole document, text mode like the std::ofstream it replaces.
+	bool WriteFile(const fs::path& file_path) const
+	{
+		std::ofstream ofs(file_path);
+		if (!ofs) {
+			return false;
+		}
+		ofs.write(buffer.data(), buffer.size());
+		return (bool)ofs;
+	}
+
+	const std::string& Buffer() const { return buffer; }
+
+private:
+	struct Element
+	{
+		std::string_view name;
+		bool has_children;
+	};
+
+	std::string buffer;
+	std::string scratch;
+	std::vector<Element> stack;
+};
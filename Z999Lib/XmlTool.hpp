@@ -1,88 +1,212 @@
 #pragma once
 
 #include "Common.hpp"
+#include "ThreadPool.hpp"
 
 class XmlTool
 {
 public:
 	bool ConvertHalfWidthJapaneseXml(const fs::path& src_path, const fs::path& out_path)
 	{
+		std::vector<fs::path> desc_paths;
 		for (auto i : fs::directory_iterator(src_path)) {
 			auto pi = fs::path(i);
 			if (StrCmpEndWith(pi.filename().string(), ".desc.xml")) {
-				ConvertHalfWidthJapaneseXml_Desc(pi, out_path);
+				desc_paths.push_back(pi);
 			}
 		}
 
+		ThreadPool::Shared().ParallelFor(desc_paths.size(), [&](std::size_t i) {
+			ConvertHalfWidthJapaneseXml_Desc(desc_paths[i], out_path);
+		});
+
 		return true;
 	}
 
+	// rewrites the value attributes under <texts> in place, everything else is copied through as is.
 	void ConvertHalfWidthJapaneseXml_Desc(const fs::path& file_path, const fs::path& out_path)
 	{
-		rapidxml::file<char> xmlFile(file_path.string().c_str()); // Default template is char
-		rapidxml::xml_document<char> doc;
-		doc.parse<0>(xmlFile.data());
-
-		auto node = doc.first_node();
-		if (!node) {
+		std::ifstream ifs(file_path, std::ios::binary);
+		if (!ifs) {
 			return;
 		}
+		std::string src((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
 
-		node = node->first_node();
-		while (node != nullptr) {
-			if (strcmp(node->name(), "texts") == 0) {
-				break;
-			}
-			node = node->next_sibling();
-		}
-		if (!node) {
+		auto texts_pos = FindTag(src, "texts", 0);
+		if (texts_pos == std::string::npos || src.find('>', texts_pos) == std::string::npos) {
 			return;
 		}
+		texts_pos = src.find('>', texts_pos);
+		auto texts_end = src.find("</texts>", texts_pos);
+		if (texts_end == std::string::npos) {
+			texts_end = src.size();
+		}
 
-		auto node_text = node->first_node();
-		while (node_text != nullptr) {
-			auto attr_text = node_text->first_attribute();
-			while (attr_text != nullptr) {
-				if (strcmp(attr_text->name(), "value") == 0) {
-					auto org_text = attr_text->value();
-					auto mod_text = wcs_to_utf8(sjis_half_to_full(utf8_to_wcs(org_text)));
-					attr_text->value(RapidXmlString(doc, mod_text));
-					break;
+		std::string dst;
+		dst.reserve(src.size());
+		std::size_t copied = 0;
+		ForEachAttribute(src, texts_pos, texts_end, [&](std::string_view name, std::size_t value_beg, std::size_t value_end) {
+			if (name == "value") {
+				dst.append(src, copied, value_beg - copied);
+				sjis_half_to_full(std::string_view(src).substr(value_beg, value_end - value_beg), dst);
+				copied = value_end;
+			}
+		});
+		dst.append(src, copied, std::string::npos);
+
+		std::ofstream ofs(fs::path(out_path).append(file_path.filename().string()), std::ios::binary);
+		ofs.write(dst.c_str(), dst.size());
+	}
+
+	// half-width katakana to full-width hiragana on utf-8 text, a following (han)dakuten mark is folded into the kana.
+	// kana without a sjis voiced form (u, wa, wo) keep the mark as a separate character.
+	static void sjis_half_to_full(std::string_view src, std::string& dst)
+	{
+		auto size = src.size();
+		for (std::size_t i = 0; i < size;) {
+			auto c = DecodeHalfWidth(src, i);
+			if (c == 0) {
+				dst += src[i++];
+				continue;
+			}
+			i += 3;
+
+			char16_t u = c;
+			if (c >= 0xFF61 && c <= 0xFF9F) {
+				auto& k = kana_table[c - 0xFF61];
+				u = k.base;
+				auto mark = DecodeHalfWidth(src, i);
+				if (mark == 0xFF9E && k.voiced != 0) {
+					u = k.voiced;
+					i += 3;
+				}
+				else if (mark == 0xFF9F && k.semi_voiced != 0) {
+					u = k.semi_voiced;
+					i += 3;
 				}
-				attr_text = attr_text->next_attribute();
 			}
-			node_text = node_text->next_sibling();
+			else if (c >= 0xFFE8 && c <= 0xFFEE) {
+				u = form_table[c - 0xFFE8];
+			}
+
+			dst += (char)(0xE0 | (u >> 12));
+			dst += (char)(0x80 | ((u >> 6) & 0x3F));
+			dst += (char)(0x80 | (u & 0x3F));
+		}
+	}
+
+private:
+	struct Kana
+	{
+		char16_t base;
+		char16_t voiced;
+		char16_t semi_voiced;
+	};
+
+	// U+FF61 - U+FF9F
+	static constexpr std::array<Kana, 0x3F> kana_table = [] {
+		constexpr char16_t base[0x3F] = {
+			0x3002, 0x300C, 0x300D, 0x3001, 0x30FB, 0x3092, 0x3041, 0x3043,
+			0x3045, 0x3047, 0x3049, 0x3083, 0x3085, 0x3087, 0x3063, 0x30FC,
+			0x3042, 0x3044, 0x3046, 0x3048, 0x304A, 0x304B, 0x304D, 0x304F,
+			0x3051, 0x3053, 0x3055, 0x3057, 0x3059, 0x305B, 0x305D, 0x305F,
+			0x3061, 0x3064, 0x3066, 0x3068, 0x306A, 0x306B, 0x306C, 0x306D,
+			0x306E, 0x306F, 0x3072, 0x3075, 0x3078, 0x307B, 0x307E, 0x307F,
+			0x3080, 0x3081, 0x3082, 0x3084, 0x3086, 0x3088, 0x3089, 0x308A,
+			0x308B, 0x308C, 0x308D, 0x308F, 0x3093, 0x309B, 0x309C,
+		};
+		std::array<Kana, 0x3F> t{};
+		for (int i = 0; i < 0x3F; i++) {
+			t[i].base = base[i];
+			auto c = 0xFF61 + i;
+			if ((c >= 0xFF76 && c <= 0xFF84) || (c >= 0xFF8A && c <= 0xFF8E)) { // ka - to, ha - ho
+				t[i].voiced = base[i] + 1;
+			}
+			if (c >= 0xFF8A && c <= 0xFF8E) {
+				t[i].semi_voiced = base[i] + 2;
+			}
 		}
-		
+		return t;
+	}();
 
-		std::string xmlString;
-		rapidxml::print(std::back_inserter(xmlString), doc);
+	// U+FFE8 - U+FFEE
+	static constexpr char16_t form_table[7] = { 0x2502, 0x2190, 0x2191, 0x2192, 0x2193, 0x25A0, 0x25CB };
 
-		std::ofstream ofs(fs::path(out_path).append(file_path.filename().string()));
-		ofs.write(xmlString.c_str(), xmlString.size());
+	// U+FF61 - U+FFEF at src[i], 0 for anything else.
+	static char16_t DecodeHalfWidth(std::string_view src, std::size_t i)
+	{
+		if (i + 3 > src.size() || (uint8_t)src[i] != 0xEF) {
+			return 0;
+		}
+		auto b1 = (uint8_t)src[i + 1];
+		auto b2 = (uint8_t)src[i + 2];
+		if (b1 < 0xBD || b1 > 0xBF || (b2 & 0xC0) != 0x80) {
+			return 0;
+		}
+		char16_t c = (char16_t)(0xF000 | ((b1 & 0x3F) << 6) | (b2 & 0x3F));
+		if (c < 0xFF61 || (c > 0xFF9F && c < 0xFFE8) || c > 0xFFEE) {
+			return 0;
+		}
+		return c;
 	}
 
-	inline std::wstring sjis_half_to_full(const std::wstring& src)
+	static std::size_t FindTag(const std::string& src, std::string_view name, std::size_t pos)
 	{
-		//DWORD flags = LCMAP_FULLWIDTH; //˪ުflag to convert to full width
-		//DWORD flags = LCMAP_HALFWIDTH; //˪ުto half width
-		//DWORD flags = LCMAP_HIRAGANA; //Ҫ骬ʪ˪ުto hiragana
-		//DWORD flags = LCMAP_KATAKANA; //ʪ˪ުto katakana
-
-		std::vector<wchar_t> buffer(src.length() * 2 + 1, 0);
-
-		auto size = (int)src.size();
-		for (int i = 0; i < size; i++) {
-			if (src[i] >= 0xFF00 && src[i] <= 0xFFEF) {
-				wchar_t temp[2] = {};
-				LCMapStringW(1041, LCMAP_FULLWIDTH, &src[i], 1, &temp[0], 1);
-				LCMapStringW(1041, LCMAP_HIRAGANA, &temp[0], 1, &buffer[i], 1);
-			}
-			else {
-				buffer[i] = src[i];
+		while ((pos = src.find(name, pos)) != std::string::npos) {
+			auto end = pos + name.size();
+			if (pos > 0 && src[pos - 1] == '<' && end < src.size() && (src[end] == '>' || src[end] == '/' || isspace((uint8_t)src[end]))) {
+				return pos - 1;
 			}
+			pos = end;
 		}
+		return std::string::npos;
+	}
+
+	// attributes of the start tags in [pos, end), comments and declarations are skipped.
+	template<typename F>
+	static void ForEachAttribute(const std::string& src, std::size_t pos, std::size_t end, F func)
+	{
+		auto func_skip_space = [&](std::size_t p) {
+			while (p < end && isspace((uint8_t)src[p])) {
+				p++;
+			}
+			return p;
+		};
 
-		return buffer.data();
+		while ((pos = src.find('<', pos)) < end) {
+			pos++;
+			if (pos >= end || src[pos] == '/' || src[pos] == '!' || src[pos] == '?') {
+				pos = src.find('>', pos);
+				continue;
+			}
+			while (pos < end && !isspace((uint8_t)src[pos]) && src[pos] != '>' && src[pos] != '/') {
+				pos++;
+			}
+			while (true) {
+				pos = func_skip_space(pos);
+				if (pos >= end || src[pos] == '>' || src[pos] == '/') {
+					break;
+				}
+				auto name_beg = pos;
+				while (pos < end && src[pos] != '=' && !isspace((uint8_t)src[pos]) && src[pos] != '>') {
+					pos++;
+				}
+				auto name = std::string_view(src).substr(name_beg, pos - name_beg);
+				pos = func_skip_space(pos);
+				if (pos >= end || src[pos] != '=') {
+					continue;
+				}
+				pos = func_skip_space(pos + 1);
+				if (pos >= end || (src[pos] != '"' && src[pos] != '\'')) {
+					continue;
+				}
+				auto close = src.find(src[pos], pos + 1);
+				if (close >= end) {
+					return;
+				}
+				func(name, pos + 1, close);
+				pos = close + 1;
+			}
+		}
 	}
-};
\ No newline at end of file
+};
@@ -26,7 +26,7 @@ int main(int argc, const char* argv[])
     std::setlocale(LC_CTYPE, "jpn");
 
     // parent path of solution
-    root_path = fs::path(winext::GetModuleFileName()).parent_path().parent_path().parent_path().parent_path();
+    root_path = ModulePath().parent_path().parent_path().parent_path().parent_path();
 
     return Catch::Session().run(argc, argv);
 }
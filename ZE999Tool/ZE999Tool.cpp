@@ -6,6 +6,7 @@
 #include "BinTool.hpp"
 #include "XmlTool.hpp"
 #include "BMFont.hpp"
+#include "SirPngWriter.hpp"
 
 #pragma comment(lib, "Z999Lib.lib")
 
@@ -17,9 +18,33 @@ int main(int argc, const char* argv[])
 
 	int result = -1;
 
+	// --name=value options can go anywhere, the rest is the command and its arguments.
+	//   --png=default|fast|max  png encoder preset for font pages
+	//   --jobs=N                threads working at once, one per hardware thread by default
+	std::vector<const char*> args;
+	bool valid_options = true;
+	for (int i = 0; i < argc; i++) {
+		std::string_view arg = argv[i];
+		if (arg.starts_with("--png=")) {
+			valid_options = valid_options && PngWriteOptions::FromName(arg.substr(6), SirPngWriter::write_options);
+		}
+		else if (arg.starts_with("--jobs=")) {
+			auto value = arg.substr(7);
+			std::size_t jobs = 0;
+			auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), jobs);
+			valid_options = valid_options && ec == std::errc() && ptr == value.data() + value.size() && jobs > 0;
+			ThreadPool::jobs = jobs;
+		}
+		else {
+			args.push_back(argv[i]);
+		}
+	}
+	argc = (int)args.size();
+	argv = args.data();
+
 	printf("\r\n");
 	do {
-		if (argc < 3) {
+		if (argc < 3 || !valid_options) {
 			break;
 		}
 
@@ -59,6 +84,24 @@ int main(int argc, const char* argv[])
 				break;
 			printf("Repacked %s.", tool.org_set.GetCountInfo().c_str());
 		}
+		else if (cmd == "sir-store-pack") {
+			if (argc < 4) {
+				break;
+			}
+			SirTool tool;
+			if (!tool.PackStore(ToAbsolutePath(argv[2]), ToAbsolutePath(argv[3])))
+				break;
+			printf("Stored %llu Xmls.", tool.stored_count);
+		}
+		else if (cmd == "sir-store-unpack") {
+			if (argc < 4) {
+				break;
+			}
+			SirTool tool;
+			if (!tool.UnpackStore(ToAbsolutePath(argv[2]), ToAbsolutePath(argv[3])))
+				break;
+			printf("Unpacked %llu Xmls.", tool.stored_count);
+		}
 		else if (cmd == "sir-copy-valid") {
 			if (argc < 4) {
 				break;
@@ -93,7 +136,7 @@ int main(int argc, const char* argv[])
 			SirTool tool;
 			if (!tool.Patch(ToAbsolutePath(argv[2]), ToAbsolutePath(argv[3]), argv[4], ToAbsolutePath(argv[5])))
 				break;
-			printf("Patched %s.", tool.patch_set.GetCountInfo().c_str());
+			printf("Patched %s, %llu Unchanged.", tool.patch_set.GetCountInfo().c_str(), tool.unchanged_count);
 		}
 		else if (cmd == "exe-patch") {
 			if (argc < 6) {
@@ -103,7 +146,8 @@ int main(int argc, const char* argv[])
 			if (!tool.ExePatch(ToAbsolutePath(argv[2]), ToAbsolutePath(argv[3]), ToAbsolutePath(argv[4]), ToAbsolutePath(argv[5])))
 				break;
 
-			printf("Exe File Generated.");
+			printf("Exe File Generated. %llu Replaced, %llu Patterns Not Found, %llu Patterns Matched More Than Once.",
+				tool.exe_replaced_count, tool.exe_unmatched_count, tool.exe_duplicated_count);
 		}
 		else if (cmd == "xml-conv-half-width-jp") {
 			if (argc < 4) {